@@ -0,0 +1,348 @@
+#ifndef ARKACOLUMNS_H
+#define ARKACOLUMNS_H
+
+// Flat column cache of converted hits: one file per field, <dir>/<field>.col,
+// each a 64-byte ArkaColumnHeader followed by the values as a little-endian
+// array. The header carries the numpy type string, so Python can np.memmap
+// the values at offset 64 (see ArkaColumns.py) and C++ can map them with
+// MappedColumn without any copy or decompression. Values are written in host
+// order, which is little-endian on every machine we run on.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "ArkaHitRecord.h"
+#include "ArkaParser.h"
+
+struct ArkaColumnHeader {
+    char     magic[8];   // "ARKACOL1"
+    char     dtype[8];   // numpy type string, e.g. "<f8", NUL padded
+    uint64_t length;     // number of values
+    uint32_t itemSize;   // bytes per value
+    char     name[36];   // field name, NUL padded
+};
+
+static_assert(sizeof(ArkaColumnHeader) == 64, "ArkaColumnHeader must stay 64 bytes, the values start at offset 64");
+
+template <typename T> struct ArkaColumnType;
+template <> struct ArkaColumnType<double>   { static const char *DType(){ return "<f8"; } };
+template <> struct ArkaColumnType<float>    { static const char *DType(){ return "<f4"; } };
+template <> struct ArkaColumnType<int64_t>  { static const char *DType(){ return "<i8"; } };
+template <> struct ArkaColumnType<int32_t>  { static const char *DType(){ return "<i4"; } };
+template <> struct ArkaColumnType<uint32_t> { static const char *DType(){ return "<u4"; } };
+template <> struct ArkaColumnType<int16_t>  { static const char *DType(){ return "<i2"; } };
+template <> struct ArkaColumnType<int8_t>   { static const char *DType(){ return "|i1"; } };
+
+inline std::string ColumnPath(const std::string &dir, const char *name){
+    return dir + "/" + name + ".col";
+}
+
+inline bool ReadColumnHeader(std::FILE *file, ArkaColumnHeader &header){
+    return std::fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "ARKACOL1", 8) == 0;
+}
+
+// The column files of names in dir are deleted, e.g. after a failed write,
+// so that no cache with a wrong or partial column is left to be mapped.
+inline void RemoveColumns(const std::string &dir, const std::vector<std::string> &names){
+    for (const std::string &name : names) std::remove(ColumnPath(dir, name.c_str()).c_str());
+}
+
+// One column being written. Values go through a 1 MB buffer; Close() writes
+// the final length into the header. A short write is latched: the length
+// only counts what reached the file, and Close() then fails.
+template <typename T>
+class ColumnWriter {
+public:
+    ColumnWriter() : fFile(nullptr), fLength(0), fFailed(false) {}
+    ~ColumnWriter(){ Close(); }
+    ColumnWriter(const ColumnWriter &) = delete;
+    ColumnWriter &operator=(const ColumnWriter &) = delete;
+
+    bool Open(const std::string &dir, const char *name){
+        fFile = std::fopen(ColumnPath(dir, name).c_str(), "wb");
+        if (!fFile) return false;
+        memset(&fHeader, 0, sizeof(fHeader));
+        memcpy(fHeader.magic, "ARKACOL1", 8);
+        strncpy(fHeader.dtype, ArkaColumnType<T>::DType(), sizeof(fHeader.dtype) - 1);
+        strncpy(fHeader.name, name, sizeof(fHeader.name) - 1);
+        fHeader.itemSize = sizeof(T);
+        fBuffer.reserve((1 << 20) / sizeof(T));
+        fLength = 0;
+        fFailed = std::fwrite(&fHeader, sizeof(fHeader), 1, fFile) != 1;
+        return !fFailed;
+    }
+
+    void Fill(T value){
+        fBuffer.push_back(value);
+        if (fBuffer.size() == fBuffer.capacity()) Flush();
+    }
+
+    bool Close(){
+        if (!fFile) return true;
+        Flush();
+        fHeader.length = fLength;
+        bool ok = !fFailed && std::fseek(fFile, 0, SEEK_SET) == 0 && std::fwrite(&fHeader, sizeof(fHeader), 1, fFile) == 1;
+        ok = std::fclose(fFile) == 0 && ok;
+        fFile = nullptr;
+        return ok;
+    }
+
+private:
+    void Flush(){
+        if (fFile && !fFailed && !fBuffer.empty()) {
+            if (std::fwrite(fBuffer.data(), sizeof(T), fBuffer.size(), fFile) == fBuffer.size())
+                fLength += fBuffer.size();
+            else
+                fFailed = true;
+        }
+        fBuffer.clear();
+    }
+
+    std::FILE        *fFile;
+    ArkaColumnHeader  fHeader;
+    std::vector<T>    fBuffer;
+    uint64_t          fLength;
+    bool              fFailed;
+};
+
+inline std::vector<std::string> HitColumnNames(bool compact);
+
+// The columns of one schema, filled hit by hit: ArkaHit's types, or with
+// compact the types of the compact tree (floats, moduleKey, short, char).
+// If Open() or Close() fails the columns written so far are deleted.
+class HitColumns {
+public:
+    explicit HitColumns(bool compact = false) : fCompact(compact) {}
+
+    bool Open(const std::string &dir){
+        fDir = dir;
+        bool ok = fEventNumber.Open(dir, "event_number");
+        if (fCompact) {
+            ok = ok && fPtF.Open(dir, "pT") && fTrkEtaF.Open(dir, "trkEta") && fTrkPhiF.Open(dir, "trkPhi")
+                    && fPhiToWaferF.Open(dir, "phiToWafer") && fModuleKey.Open(dir, "moduleKey")
+                    && fNStripS.Open(dir, "nStrip") && fChargeC.Open(dir, "charge");
+        } else {
+            ok = ok && fPt.Open(dir, "pT") && fTrkEta.Open(dir, "trkEta") && fTrkPhi.Open(dir, "trkPhi")
+                    && fPhiToWafer.Open(dir, "phiToWafer") && fNStrip.Open(dir, "nStrip") && fBec.Open(dir, "bec")
+                    && fLayer.Open(dir, "layer") && fEtaModule.Open(dir, "etaModule")
+                    && fPhiModule.Open(dir, "phiModule") && fSide.Open(dir, "side") && fCharge.Open(dir, "charge");
+        }
+        if (!ok) Drop();
+        return ok;
+    }
+
+    void Fill(const ArkaHit &hit){
+        fEventNumber.Fill(hit.event_number);
+        if (fCompact) {
+            fPtF.Fill(hit.pT);
+            fTrkEtaF.Fill(hit.trkEta);
+            fTrkPhiF.Fill(hit.trkPhi);
+            fPhiToWaferF.Fill(hit.phiToWafer);
+            fModuleKey.Fill(PackModuleKey(hit.bec, hit.layer, hit.etaModule, hit.phiModule, hit.side));
+            fNStripS.Fill(hit.nStrip);
+            fChargeC.Fill(hit.charge);
+        } else {
+            fPt.Fill(hit.pT);
+            fTrkEta.Fill(hit.trkEta);
+            fTrkPhi.Fill(hit.trkPhi);
+            fPhiToWafer.Fill(hit.phiToWafer);
+            fNStrip.Fill(hit.nStrip);
+            fBec.Fill(hit.bec);
+            fLayer.Fill(hit.layer);
+            fEtaModule.Fill(hit.etaModule);
+            fPhiModule.Fill(hit.phiModule);
+            fSide.Fill(hit.side);
+            fCharge.Fill(hit.charge);
+        }
+    }
+
+    bool Close(){
+        bool ok = fEventNumber.Close();
+        ok = fPt.Close() && ok;
+        ok = fTrkEta.Close() && ok;
+        ok = fTrkPhi.Close() && ok;
+        ok = fPhiToWafer.Close() && ok;
+        ok = fNStrip.Close() && ok;
+        ok = fBec.Close() && ok;
+        ok = fLayer.Close() && ok;
+        ok = fEtaModule.Close() && ok;
+        ok = fPhiModule.Close() && ok;
+        ok = fSide.Close() && ok;
+        ok = fCharge.Close() && ok;
+        ok = fPtF.Close() && ok;
+        ok = fTrkEtaF.Close() && ok;
+        ok = fTrkPhiF.Close() && ok;
+        ok = fPhiToWaferF.Close() && ok;
+        ok = fModuleKey.Close() && ok;
+        ok = fNStripS.Close() && ok;
+        ok = fChargeC.Close() && ok;
+        if (!ok) RemoveColumns(fDir, HitColumnNames(fCompact));
+        return ok;
+    }
+
+private:
+    void Drop(){
+        Close();
+        RemoveColumns(fDir, HitColumnNames(fCompact));
+    }
+
+    bool                   fCompact;
+    std::string            fDir;
+    ColumnWriter<int64_t>  fEventNumber;
+    ColumnWriter<double>   fPt, fTrkEta, fTrkPhi, fPhiToWafer, fCharge;
+    ColumnWriter<int32_t>  fNStrip, fBec, fLayer, fEtaModule, fPhiModule, fSide;
+    ColumnWriter<float>    fPtF, fTrkEtaF, fTrkPhiF, fPhiToWaferF;
+    ColumnWriter<uint32_t> fModuleKey;
+    ColumnWriter<int16_t>  fNStripS;
+    ColumnWriter<int8_t>   fChargeC;
+};
+
+// Zero-copy view of one column; IsOpen() is false if the file is missing or
+// its type is not T.
+template <typename T>
+class MappedColumn {
+public:
+    MappedColumn(const std::string &dir, const char *name) : fFile(ColumnPath(dir, name).c_str()), fData(nullptr), fLength(0) {
+        ArkaColumnHeader header;
+        if (fFile.size() < sizeof(header)) return;
+        memcpy(&header, fFile.begin(), sizeof(header));
+        if (memcmp(header.magic, "ARKACOL1", 8) != 0 || strcmp(header.dtype, ArkaColumnType<T>::DType()) != 0 ||
+            fFile.size() < sizeof(header) + header.length * sizeof(T)) return;
+        fData = reinterpret_cast<const T *>(fFile.begin() + sizeof(header));
+        fLength = header.length;
+    }
+
+    bool      IsOpen() const { return fData != nullptr; }
+    size_t    size()   const { return fLength; }
+    const T  *begin()  const { return fData; }
+    const T  *end()    const { return fData + fLength; }
+    const T  &operator[](size_t i) const { return fData[i]; }
+
+private:
+    MappedFile  fFile;
+    const T    *fData;
+    size_t      fLength;
+};
+
+inline bool CopyColumnValues(std::FILE *in, std::FILE *out, uint64_t bytes, std::vector<char> &buffer){
+    while (bytes > 0) {
+        size_t n = std::fread(buffer.data(), 1, bytes < buffer.size() ? bytes : buffer.size(), in);
+        if (n == 0 || std::fwrite(buffer.data(), 1, n, out) != n) return false;
+        bytes -= n;
+    }
+    return true;
+}
+
+// Appends the columns listed in names of the caches in dirs, in order, into
+// the cache in dir. The types must agree between the caches, and all columns
+// must come out with the same length; otherwise the columns in dir are
+// deleted and false is returned.
+inline bool ConcatenateColumns(const std::vector<std::string> &dirs, const std::string &dir,
+                               const std::vector<std::string> &names){
+    std::vector<char> buffer(4 << 20);
+    bool ok = true, haveLength = false;
+    uint64_t length = 0;
+    for (const std::string &name : names) {
+        std::FILE *out = std::fopen(ColumnPath(dir, name.c_str()).c_str(), "wb");
+        if (!out) {
+            ok = false;
+            break;
+        }
+        ArkaColumnHeader total;
+        bool first = true;
+        for (const std::string &part : dirs) {
+            std::FILE *in = std::fopen(ColumnPath(part, name.c_str()).c_str(), "rb");
+            ArkaColumnHeader header;
+            if (!in || !ReadColumnHeader(in, header) || (!first && strcmp(header.dtype, total.dtype) != 0)) {
+                if (in) std::fclose(in);
+                ok = false;
+                break;
+            }
+            if (first) {
+                total = header;
+                total.length = 0;
+                ok = std::fwrite(&total, sizeof(total), 1, out) == 1;
+                first = false;
+            }
+            total.length += header.length;
+            ok = ok && CopyColumnValues(in, out, header.length * header.itemSize, buffer);
+            std::fclose(in);
+            if (!ok) break;
+        }
+        ok = ok && !first && (!haveLength || total.length == length);
+        ok = ok && std::fseek(out, 0, SEEK_SET) == 0 && std::fwrite(&total, sizeof(total), 1, out) == 1;
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok) break;
+        length = total.length;
+        haveLength = true;
+    }
+    if (!ok) RemoveColumns(dir, names);
+    return ok;
+}
+
+// Adds the caches in dirs, in order, to the end of the existing cache in dir:
+// the new values are written after the old ones and the header's length is
+// updated, nothing already in dir is copied. The types must agree. The
+// values of every column are appended and flushed first and the headers are
+// only rewritten once all columns succeeded with the same length, so a
+// failure on the way truncates the columns back to the old cache. If that
+// or a header write fails, the cache in dir is deleted and has to be joined
+// again from scratch.
+inline bool AppendColumns(const std::vector<std::string> &dirs, const std::string &dir,
+                          const std::vector<std::string> &names){
+    std::vector<char> buffer(4 << 20);
+    std::vector<ArkaColumnHeader> totals(names.size());
+    std::vector<long> oldEnds(names.size(), -1);
+    bool ok = true;
+    for (size_t c = 0; ok && c < names.size(); c++) {
+        std::FILE *out = std::fopen(ColumnPath(dir, names[c].c_str()).c_str(), "r+b");
+        if (!out) {
+            ok = false;
+            break;
+        }
+        ArkaColumnHeader &total = totals[c];
+        ok = ReadColumnHeader(out, total);
+        if (ok) {
+            oldEnds[c] = long(sizeof(total) + total.length * total.itemSize);
+            ok = std::fseek(out, oldEnds[c], SEEK_SET) == 0;
+        }
+        for (const std::string &part : dirs) {
+            if (!ok) break;
+            std::FILE *in = std::fopen(ColumnPath(part, names[c].c_str()).c_str(), "rb");
+            ArkaColumnHeader header;
+            ok = in && ReadColumnHeader(in, header) && strcmp(header.dtype, total.dtype) == 0 &&
+                 CopyColumnValues(in, out, header.length * header.itemSize, buffer);
+            if (ok) total.length += header.length;
+            if (in) std::fclose(in);
+        }
+        ok = ok && totals[c].length == totals[0].length;
+        ok = std::fclose(out) == 0 && ok;
+    }
+    if (!ok) {
+        // the headers are untouched, cutting the appended values restores the old cache
+        bool restored = true;
+        for (size_t c = 0; c < names.size(); c++)
+            if (oldEnds[c] >= 0) restored = truncate(ColumnPath(dir, names[c].c_str()).c_str(), oldEnds[c]) == 0 && restored;
+        if (!restored) RemoveColumns(dir, names);
+        return false;
+    }
+    for (size_t c = 0; ok && c < names.size(); c++) {
+        std::FILE *out = std::fopen(ColumnPath(dir, names[c].c_str()).c_str(), "r+b");
+        ok = out && std::fwrite(&totals[c], sizeof(totals[c]), 1, out) == 1;
+        if (out) ok = std::fclose(out) == 0 && ok;
+    }
+    if (!ok) RemoveColumns(dir, names);
+    return ok;
+}
+
+// Field names of the cache written by HitColumns for either schema.
+inline std::vector<std::string> HitColumnNames(bool compact){
+    if (compact) return {"event_number", "pT", "trkEta", "trkPhi", "phiToWafer", "moduleKey", "nStrip", "charge"};
+    return {"event_number", "pT", "trkEta", "trkPhi", "phiToWafer", "nStrip", "bec", "layer",
+            "etaModule", "phiModule", "side", "charge"};
+}
+
+#endif
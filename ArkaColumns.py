@@ -0,0 +1,32 @@
+import os, struct, sys
+import numpy as np
+#### Column cache written by MakeTree(..., "cache=<dir>") or MakeTreeBatch -O "cache=<dir>":
+#### one <field>.col per field, a 64-byte header (see ArkaColumns.h) followed by the values.
+#### run like: python ArkaColumns.py <dir>        (lists the columns)
+#### or in python:  import ArkaColumns; hits = ArkaColumns.load('cache'); hits['phiToWafer'][hits['layer'] == 2]
+#### a compact cache has moduleKey instead of bec, layer, ...:  hits['phiToWafer'][(hits['moduleKey'] >> 16) & 0xff == 2]
+
+HEADER = struct.Struct('<8s8sQI36s')   # magic, dtype, length, item size, name
+
+def read_header(path):
+    with open(path, 'rb') as f:
+        magic, dtype, length, itemSize, name = HEADER.unpack(f.read(HEADER.size))
+    if magic != b'ARKACOL1':
+        raise ValueError(path + ' is not a column file')
+    return dtype.rstrip(b'\0').decode(), length, name.rstrip(b'\0').decode()
+
+def load_column(path):
+    ### the values are mapped, not read: only the pages that are used are loaded
+    dtype, length, name = read_header(path)
+    return np.memmap(path, dtype=np.dtype(dtype), mode='r', offset=HEADER.size, shape=(length,))
+
+def load(directory):
+    columns = {}
+    for fileName in sorted(os.listdir(directory)):
+        if fileName.endswith('.col'):
+            columns[fileName[:-4]] = load_column(os.path.join(directory, fileName))
+    return columns
+
+if __name__ == '__main__':
+    for name, values in sorted(load(sys.argv[1]).items()):
+        print('%-14s %-4s %d' % (name, values.dtype.str, len(values)))
@@ -0,0 +1,234 @@
+#ifndef ARKAGENERATOR_H
+#define ARKAGENERATOR_H
+
+// Synthetic log.RAWtoALL for benchmarks and tests without grid access: the
+// "Arka" hit lines in the field order printed by
+// SCTLorentzMonTool::fillHistograms (event, pT, eta, phi, phiToWafer,
+// nStrip, bec, layer, eta module, phi module, side, charge), preceded by the
+// time stamp the job log adds, and interleaved with Athena noise: event loop
+// banners, algorithm and service messages and the odd warning. The hit
+// fraction sets how many of the lines are hits, a raw log has a few percent,
+// a grepped file all of them. The same seed gives the same log.
+// WriteArkaTarball packs one into a .tgz laid out like the grid job logs.
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+class ArkaLogGenerator {
+public:
+    explicit ArkaLogGenerator(double hitFraction = 0.05, double hitsPerEvent = 40, uint64_t seed = 1)
+        : fHitFraction(hitFraction <= 0 ? 1e-3 : hitFraction > 1 ? 1 : hitFraction), fHitsPerEvent(hitsPerEvent),
+          fRandom(seed), fEvent(1000000), fRun(358031), fSeconds(36000), fHitsLeft(0), fEvents(0), fHits(0), fLines(0) {}
+
+    // Appends the next line, with its newline, to out. Returns true for a hit
+    // line. With a hit fraction of 1 there are only hit lines, as in a grepped file.
+    bool NextLine(std::string &out){
+        fLines++;
+        if (fHitsLeft == 0) {
+            while (fHitsLeft == 0) NewEvent();
+            if (fHitFraction < 1) {
+                Banner(out);
+                return false;
+            }
+        }
+        if (Uniform() >= fHitFraction) {
+            Noise(out);
+            return false;
+        }
+        Hit(out);
+        fHitsLeft--;
+        fHits++;
+        return true;
+    }
+
+    long long GetHits()  const { return fHits; }
+    long long GetLines() const { return fLines; }
+
+private:
+    double Uniform(){ return std::uniform_real_distribution<double>(0, 1)(fRandom); }
+    int    Integer(int lo, int hi){ return std::uniform_int_distribution<int>(lo, hi)(fRandom); }
+
+    void Stamp(std::string &out){
+        char stamp[16];
+        long s = fSeconds / 10;
+        std::snprintf(stamp, sizeof(stamp), "%02ld:%02ld:%02ld ", s / 3600 % 24, s / 60 % 60, s % 60);
+        out += stamp;
+    }
+
+    void NewEvent(){
+        fEvent += 1 + (Uniform() < 0.1 ? Integer(1, 20) : 0);
+        fEvents++;
+        fSeconds += Integer(1, 4);
+        fHitsLeft = std::poisson_distribution<int>(fHitsPerEvent)(fRandom);
+    }
+
+    void Banner(std::string &out){
+        char line[200];
+        std::snprintf(line, sizeof(line), "AthenaEventLoopMgr                                   INFO   ===>>>  start processing event #%lld, run #%d %lld events processed so far  <<<===\n",
+                      fEvent, fRun, fEvents - 1);
+        out += line;
+    }
+
+    void Noise(std::string &out){
+        static const char *kNoise[] = {
+            "SCTLorentzMonTool                                    DEBUG fillHistograms: track collection CombinedInDetTracks retrieved\n",
+            "ToolSvc.InDetSCT_ConditionsSummaryTool               DEBUG isGood: wafer flagged by the byte stream errors tool\n",
+            "AthenaEventLoopMgr                                   INFO   ===>>>  done processing event <<<===\n",
+            "InDetSCT_ClusterOnTrackTool                          DEBUG correct: Lorentz shift applied to the cluster position\n",
+            "IOVDbSvc                                             INFO Opening COOL connection for COOLOFL_SCT/CONDBR2\n",
+            "Py:Athena            INFO executing ROOT6Setup\n",
+            "ByteStreamInputSvc                                   INFO Picked valid file: data18_13TeV.00358031.physics_Main.daq.RAW._lb0500._SFO-4._0001.data\n",
+            "SCT_RodDecoder                                       WARNING decodeData: ABCD error in the header of link 48\n",
+        };
+        static const double kWeight[] = {0.25, 0.2, 0.2, 0.2, 0.05, 0.04, 0.03, 0.03};
+        double u = Uniform();
+        size_t i = 0;
+        while (i + 1 < sizeof(kNoise) / sizeof(kNoise[0]) && u >= kWeight[i]) u -= kWeight[i++];
+        if (i == 4 || i == 5) Stamp(out);
+        out += kNoise[i];
+    }
+
+    // Distributions shaped like the real data: the barrel holds most hits,
+    // pT falls steeply above the 500 MeV cut, clusters are 1-4 strips wide
+    // and phiToWafer peaks near the Lorentz angle.
+    void Hit(std::string &out){
+        static const int kBarrelPhi[4] = {32, 40, 48, 56};
+        int bec = Uniform() < 0.7 ? 0 : (Uniform() < 0.5 ? -2 : 2);
+        int layer, eta, phi;
+        if (bec == 0) {
+            layer = Integer(0, 3);
+            eta = Integer(1, 6) * (Uniform() < 0.5 ? -1 : 1);
+            phi = Integer(0, kBarrelPhi[layer] - 1);
+        } else {
+            layer = Integer(0, 8);
+            eta = Integer(0, 2);
+            phi = Integer(0, eta == 0 ? 51 : 39);
+        }
+        int side = Integer(0, 1);
+        int charge = Uniform() < 0.5 ? -1 : 1;
+        double pT = 500 + std::exponential_distribution<double>(1. / 2500)(fRandom);
+        double trkEta = bec == 0 ? std::uniform_real_distribution<double>(-1.4, 1.4)(fRandom)
+                                 : bec * std::uniform_real_distribution<double>(0.6, 1.25)(fRandom);
+        double trkPhi = std::uniform_real_distribution<double>(-M_PI, M_PI)(fRandom);
+        double phiToWafer = std::normal_distribution<double>(-4., 15.)(fRandom);
+        if (phiToWafer < -89.9 || phiToWafer > 89.9) phiToWafer = std::fmod(phiToWafer, 89.9);
+        int nStrip = 1 + std::binomial_distribution<int>(3, 0.15 + std::fabs(phiToWafer + 4.) / 120.)(fRandom);
+        char line[200];
+        Stamp(out);
+        std::snprintf(line, sizeof(line), "Arka %lld %.6g %.6g %.6g %.6g %d %d %d %d %d %d %d\n", fEvent, pT, trkEta,
+                      trkPhi, phiToWafer, nStrip, bec, layer, eta, phi, side, charge);
+        out += line;
+    }
+
+    double          fHitFraction;
+    double          fHitsPerEvent;
+    std::mt19937_64 fRandom;
+    long long       fEvent;
+    int             fRun;
+    long            fSeconds; // tenths of a second
+    int             fHitsLeft;
+    long long       fEvents;
+    long long       fHits;
+    long long       fLines;
+};
+
+// Writes a log of nHits hit lines (plus the noise) to path. Returns the
+// number of bytes written, -1 on error.
+inline long long GenerateArkaLog(const char *path, long long nHits, double hitFraction = 0.05, uint64_t seed = 1){
+    std::FILE *out = std::fopen(path, "w");
+    if (!out) return -1;
+    ArkaLogGenerator generator(hitFraction, 40, seed);
+    std::string buffer;
+    long long bytes = 0;
+    bool ok = true;
+    while (ok && generator.GetHits() < nHits) {
+        generator.NextLine(buffer);
+        if (buffer.size() >= (1 << 20) || generator.GetHits() == nHits) {
+            ok = std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+            bytes += buffer.size();
+            buffer.clear();
+        }
+    }
+    ok = std::fclose(out) == 0 && ok;
+    return ok ? bytes : -1;
+}
+
+// One 512-byte ustar header.
+inline void ArkaTarHeader(char header[512], const std::string &name, long long size, char type){
+    memset(header, 0, 512);
+    strncpy(header, name.c_str(), 99);
+    std::snprintf(header + 100, 8, "%07o", type == '5' ? 0755 : 0644);
+    std::snprintf(header + 108, 8, "%07o", 0);
+    std::snprintf(header + 116, 8, "%07o", 0);
+    std::snprintf(header + 124, 12, "%011llo", size);
+    std::snprintf(header + 136, 12, "%011o", 1514764800u);
+    header[156] = type;
+    memcpy(header + 257, "ustar", 6);
+    memcpy(header + 263, "00", 2);
+    memset(header + 148, ' ', 8);
+    unsigned sum = 0;
+    for (int i = 0; i < 512; i++) sum += (unsigned char)header[i];
+    std::snprintf(header + 148, 8, "%06o", sum);
+}
+
+// Writes a .tgz like the grid job output: dir/, dir/jobReport.json and
+// dir/log.RAWtoALL holding a synthetic log of nHits hits. The log is
+// generated twice, once for its size in the tar header and once into the
+// archive, so memory stays flat. Returns the size of the log, -1 on error.
+inline long long WriteArkaTarball(const char *path, const char *dir, long long nHits, double hitFraction = 0.05,
+                                  uint64_t seed = 1){
+    long long size = 0;
+    {
+        ArkaLogGenerator generator(hitFraction, 40, seed);
+        std::string line;
+        while (generator.GetHits() < nHits) {
+            generator.NextLine(line);
+            size += line.size();
+            line.clear();
+        }
+    }
+    gzFile out = gzopen(path, "wb6");
+    if (!out) return -1;
+    gzbuffer(out, 1 << 20);
+    std::string base = std::string(dir) + "/";
+    char report[256];
+    int reportSize = std::snprintf(report, sizeof(report), "{\"exitCode\": 0, \"exitMsg\": \"OK\", \"name\": \"RAWtoALL\", \"seed\": %llu}\n",
+                                   (unsigned long long)seed);
+    char header[512];
+    std::vector<char> zeros(1024, 0);
+    bool ok = true;
+    auto member = [&](const std::string &name, long long bytes, char type){
+        ArkaTarHeader(header, name, bytes, type);
+        ok = ok && gzwrite(out, header, 512) == 512;
+    };
+    auto pad = [&](long long bytes){
+        int padding = (512 - bytes % 512) % 512;
+        ok = ok && (padding == 0 || gzwrite(out, zeros.data(), padding) == padding);
+    };
+    member(base, 0, '5');
+    member(base + "jobReport.json", reportSize, '0');
+    ok = ok && gzwrite(out, report, reportSize) == reportSize;
+    pad(reportSize);
+    member(base + "log.RAWtoALL", size, '0');
+    ArkaLogGenerator generator(hitFraction, 40, seed);
+    std::string buffer;
+    while (ok && generator.GetHits() < nHits) {
+        generator.NextLine(buffer);
+        if (buffer.size() >= (1 << 20) || generator.GetHits() == nHits) {
+            ok = gzwrite(out, buffer.data(), buffer.size()) == (int)buffer.size();
+            buffer.clear();
+        }
+    }
+    pad(size);
+    ok = ok && gzwrite(out, zeros.data(), 1024) == 1024; // end of archive
+    ok = gzclose(out) == Z_OK && ok;
+    return ok ? size : -1;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef ARKAHITRECORD_H
+#define ARKAHITRECORD_H
+
+// Binary form of one "Arka" hit line, shared by SCTLorentzMonTool (writer)
+// and the converters (reader, see ArkaInput.h). A record file (.arkb) is a
+// 16-byte ArkaRecordHeader followed by fixed-size ArkaHitRecords in host
+// byte order; the header's version and record size are checked on reading.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+struct ArkaRecordHeader {
+    char     magic[4];   // "ARKB"
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+};
+
+// The wafer is its packed module key (PackModuleKey below), which the tool
+// keeps per wafer hash; the readers unpack it.
+struct ArkaHitRecord {
+    uint64_t event_number;
+    float    pT;
+    float    trkEta;
+    float    trkPhi;
+    float    phiToWafer;
+    uint32_t moduleKey;
+    int16_t  nStrip;
+    int8_t   charge;
+    int8_t   reserved;
+};
+
+static_assert(sizeof(ArkaRecordHeader) == 16, "ArkaRecordHeader must stay 16 bytes");
+static_assert(sizeof(ArkaHitRecord) == 32, "ArkaHitRecord must stay 32 bytes, it is the on-disk format");
+
+// 1: bec, layer, etaModule, phiModule and side as separate bytes
+// 2: packed into moduleKey
+const uint32_t kArkaRecordVersion = 2;
+
+// bec, layer, etaModule, phiModule and side of a wafer in one 32-bit key:
+// bits 24-31 bec+128, 16-23 layer, 8-15 eta+128, 1-7 phi, 0 side. Keys sort
+// by bec, then layer, eta, phi and side.
+inline uint32_t PackModuleKey(int bec, int layer, int eta, int phi, int side){
+    return (uint32_t(bec + 128) & 0xff) << 24 | (uint32_t(layer) & 0xff) << 16 | (uint32_t(eta + 128) & 0xff) << 8 |
+           (uint32_t(phi) & 0x7f) << 1 | (uint32_t(side) & 1);
+}
+
+inline void UnpackModuleKey(uint32_t key, int &bec, int &layer, int &eta, int &phi, int &side){
+    bec   = int(key >> 24 & 0xff) - 128;
+    layer = int(key >> 16 & 0xff);
+    eta   = int(key >> 8 & 0xff) - 128;
+    phi   = int(key >> 1 & 0x7f);
+    side  = int(key & 1);
+}
+
+inline bool ArkaRecordHeaderOk(const ArkaRecordHeader &header){
+    return memcmp(header.magic, "ARKB", 4) == 0 && header.version == kArkaRecordVersion &&
+           header.recordSize == sizeof(ArkaHitRecord);
+}
+
+// Buffers records and writes them out in large blocks; the destructor
+// flushes and closes. A failed write is latched, so that Flush() and Close()
+// report it even if later writes succeed: the file is then incomplete.
+// Not thread safe, one writer per file.
+class ArkaRecordWriter {
+public:
+    explicit ArkaRecordWriter(const char *path, size_t bufferRecords = 1 << 15)
+        : fFile(std::fopen(path, "wb")), fCount(0), fFailed(false){
+        fBuffer.reserve(bufferRecords);
+        if (!fFile) return;
+        ArkaRecordHeader header = {{'A', 'R', 'K', 'B'}, kArkaRecordVersion, sizeof(ArkaHitRecord), 0};
+        if (std::fwrite(&header, sizeof(header), 1, fFile) != 1) {
+            std::fclose(fFile);
+            fFile = nullptr;
+        }
+    }
+    ~ArkaRecordWriter(){
+        if (fFile && !Close()) std::fprintf(stderr, "error: writing the hit records failed, the file is incomplete\n");
+    }
+    ArkaRecordWriter(const ArkaRecordWriter &) = delete;
+    ArkaRecordWriter &operator=(const ArkaRecordWriter &) = delete;
+
+    bool IsOpen() const { return fFile != nullptr; }
+    bool Failed() const { return fFailed; }
+    unsigned long long GetCount() const { return fCount; }
+
+    void Write(const ArkaHitRecord &record){
+        fBuffer.push_back(record);
+        fCount++;
+        if (fBuffer.size() == fBuffer.capacity()) Flush();
+    }
+
+    // False if this or any earlier write failed.
+    bool Flush(){
+        bool ok = fFile && std::fwrite(fBuffer.data(), sizeof(ArkaHitRecord), fBuffer.size(), fFile) == fBuffer.size()
+                  && std::fflush(fFile) == 0;
+        fBuffer.clear();
+        if (!ok) fFailed = true;
+        return !fFailed;
+    }
+
+    // False if any write or the close failed.
+    bool Close(){
+        if (!fFile) return !fFailed;
+        bool ok = Flush();
+        ok = std::fclose(fFile) == 0 && ok;
+        fFile = nullptr;
+        if (!ok) fFailed = true;
+        return ok;
+    }
+
+private:
+    std::FILE                 *fFile;
+    std::vector<ArkaHitRecord> fBuffer;
+    unsigned long long         fCount;
+    bool                       fFailed;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef ARKAINPUT_H
+#define ARKAINPUT_H
+
+// One entry point over all the inputs the converters understand: a grepped
+// text file, a raw log.RAWtoALL, a grid .tgz holding log.RAWtoALL, or a
+// binary record file (.arkb) written by SCTLorentzMonTool.
+
+#include <cstring>
+#include "ArkaHitRecord.h"
+#include "ArkaParser.h"
+#include "ArkaStats.h"
+#include "ArkaTarReader.h"
+
+inline bool IsTarball(const char *name){
+    size_t n = strlen(name);
+    return (n >= 4 && strcmp(name + n - 4, ".tgz") == 0) || (n >= 7 && strcmp(name + n - 7, ".tar.gz") == 0);
+}
+
+inline bool IsHitRecordFile(const char *name){
+    size_t n = strlen(name);
+    return n >= 5 && strcmp(name + n - 5, ".arkb") == 0;
+}
+
+// Copies every record of a mapped .arkb file into hit and calls fn(hit) after
+// each one. Returns the number of hits, -1 if the header does not match.
+template <typename Fn>
+long long ForEachHitRecord(const char *begin, const char *end, ArkaHit &hit, Fn fn){
+    ArkaRecordHeader header;
+    if (end - begin < (long)sizeof(header)) return -1;
+    memcpy(&header, begin, sizeof(header));
+    if (!ArkaRecordHeaderOk(header)) return -1;
+    long long count = 0;
+    ArkaHitRecord record;
+    for (const char *p = begin + sizeof(header); end - p >= (long)sizeof(record); p += sizeof(record)) {
+        memcpy(&record, p, sizeof(record));
+        hit.event_number = record.event_number;
+        hit.pT           = record.pT;
+        hit.trkEta       = record.trkEta;
+        hit.trkPhi       = record.trkPhi;
+        hit.phiToWafer   = record.phiToWafer;
+        hit.nStrip       = record.nStrip;
+        UnpackModuleKey(record.moduleKey, hit.bec, hit.layer, hit.etaModule, hit.phiModule, hit.side);
+        hit.charge       = record.charge;
+        count++;
+        fn(hit);
+    }
+    return count;
+}
+
+// Parses every hit line of [begin, end) into hit and calls fn(hit) after
+// each one. Returns the number of hits. With stats the lines and bytes are
+// counted and the time goes to stats->parse; counting all lines is an extra
+// pass, so it is only done then.
+template <typename Fn>
+long long ForEachHitInRange(const char *begin, const char *end, ArkaHit &hit, Fn fn, ArkaInputStats *stats = nullptr){
+    long long count = 0, marked = 0;
+    if (stats) {
+        stats->bytesScanned += end - begin;
+        for (const char *p = begin; (p = static_cast<const char *>(memchr(p, '\n', end - p))); p++) stats->linesScanned++;
+        stats->parse.Start();
+    }
+    ScanArkaLines(begin, end, [&](const char *marker, const char *eol){
+        marked++;
+        if (ParseArkaFields(marker + 4, eol, hit)) {
+            count++;
+            fn(hit);
+        }
+    });
+    if (stats) {
+        stats->parse.Stop();
+        stats->linesMarked += marked;
+        stats->linesAccepted += count;
+    }
+    return count;
+}
+
+// Same over a whole input. Text and record files are mapped, tarballs are
+// inflated on the fly. Returns the number of hits, -1 if the input cannot be read.
+template <typename Fn>
+long long ForEachArkaHit(const char *path, ArkaHit &hit, Fn fn, ArkaInputStats *stats = nullptr){
+    if (IsTarball(path)) {
+        TarGzReader in(path);
+        if (stats) {
+            struct stat st;
+            if (stat(path, &st) == 0) stats->bytesIn += st.st_size;
+            stats->read.Start();
+        }
+        if (!in.IsOpen() || !in.NextMember("log.RAWtoALL")) {
+            if (stats) stats->read.Stop(); // the time spent looking for the member still counts
+            return -1;
+        }
+        long long count = 0;
+        bool ok = ForEachBlock(in, [&](const char *begin, const char *end){
+            if (stats) stats->read.Stop();
+            count += ForEachHitInRange(begin, end, hit, fn, stats);
+            if (stats) stats->read.Start();
+        });
+        if (stats) stats->read.Stop();
+        return ok ? count : -1;
+    }
+    MappedFile in(path);
+    if (!in.IsOpen()) return -1;
+    if (stats) stats->bytesIn += in.size();
+    if (IsHitRecordFile(path)) {
+        if (stats) stats->parse.Start();
+        long long count = ForEachHitRecord(in.begin(), in.end(), hit, fn);
+        if (stats) {
+            stats->parse.Stop();
+            stats->bytesScanned += in.size();
+            if (count > 0) stats->linesAccepted += count;
+        }
+        return count;
+    }
+    return ForEachHitInRange(in.begin(), in.end(), hit, fn, stats);
+}
+
+#endif
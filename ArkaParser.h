@@ -0,0 +1,198 @@
+#ifndef ARKAPARSER_H
+#define ARKAPARSER_H
+
+// Allocation-free parsing of the "Arka" hit lines printed by
+// SCTLorentzMonTool::fillHistograms. Kept free of ROOT so that it can be
+// included from the macros as well as from plain C++ programs.
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+// One hit, in the field order of the printout:
+// <timeStamp> Arka event_number pT eta trackPhi phiToWafer nStrip bec layer eta phi side charge
+struct ArkaHit {
+    long long event_number;
+    double    pT;
+    double    trkEta;
+    double    trkPhi;
+    double    phiToWafer;
+    int       nStrip;
+    int       bec;
+    int       layer;
+    int       etaModule;
+    int       phiModule;
+    int       side;
+    double    charge;
+};
+
+// Read-only view of a whole file through mmap. The pages are only touched
+// when they are parsed, so no copy of the log is ever made.
+class MappedFile {
+public:
+    explicit MappedFile(const char *path) : fFd(-1), fData(nullptr), fSize(0) {
+        fFd = open(path, O_RDONLY);
+        if (fFd < 0) return;
+        struct stat st;
+        if (fstat(fFd, &st) != 0) return;
+        fSize = st.st_size;
+        if (fSize == 0) return;
+        void *data = mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fFd, 0);
+        if (data == MAP_FAILED) { fSize = 0; return; }
+        madvise(data, fSize, MADV_SEQUENTIAL);
+        fData = data;
+    }
+    ~MappedFile() {
+        if (fData) munmap(fData, fSize);
+        if (fFd >= 0) close(fFd);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool        IsOpen() const { return fFd >= 0; }
+    const char *begin()  const { return static_cast<const char *>(fData); }
+    const char *end()    const { return begin() + (fData ? fSize : 0); }
+    size_t      size()   const { return fData ? fSize : 0; }
+
+private:
+    int    fFd;
+    void  *fData;
+    size_t fSize;
+};
+
+inline const char *SkipBlanks(const char *p, const char *end){
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
+
+inline const char *SkipToken(const char *p, const char *end){
+    p = SkipBlanks(p, end);
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') ++p;
+    return p;
+}
+
+template <typename T>
+inline bool ParseField(const char *&p, const char *end, T &value){
+    p = SkipBlanks(p, end);
+    std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+// Parses the twelve numbers that follow the "Arka" marker, p pointing just
+// past the marker and end at the end of the line.
+inline bool ParseArkaFields(const char *p, const char *end, ArkaHit &hit){
+    return ParseField(p, end, hit.event_number)
+        && ParseField(p, end, hit.pT)
+        && ParseField(p, end, hit.trkEta)
+        && ParseField(p, end, hit.trkPhi)
+        && ParseField(p, end, hit.phiToWafer)
+        && ParseField(p, end, hit.nStrip)
+        && ParseField(p, end, hit.bec)
+        && ParseField(p, end, hit.layer)
+        && ParseField(p, end, hit.etaModule)
+        && ParseField(p, end, hit.phiModule)
+        && ParseField(p, end, hit.side)
+        && ParseField(p, end, hit.charge);
+}
+
+// Search for the "Arka" marker printed in front of every hit, in any case
+// and whatever follows it, as the grep -i "Arka" it replaces did. The vector
+// versions compare the first and last letter of "arka" (folded to lower case
+// by setting bit 0x20, which only maps 'A' and 'a' to 'a') over 16 or 32
+// bytes at a time and only check the full marker where both match, which is
+// rare in Athena output. AVX2 is picked at run time, SSE2 is always there on
+// x86-64 and other platforms use the scalar loop.
+inline bool IsArkaMarker(const char *p){
+    return (p[0] | 0x20) == 'a' && (p[1] | 0x20) == 'r' && (p[2] | 0x20) == 'k' && (p[3] | 0x20) == 'a';
+}
+
+inline const char *FindArkaMarkerScalar(const char *begin, const char *end){
+    for (const char *p = begin; end - p >= 4; p++)
+        if (IsArkaMarker(p)) return p;
+    return nullptr;
+}
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ARKA_SIMD_X86 1
+
+inline const char *FindArkaMarkerSSE2(const char *p, const char *end){
+    const __m128i fold = _mm_set1_epi8(0x20);
+    const __m128i a    = _mm_set1_epi8('a');
+    while (end - p >= 16 + 3) {
+        __m128i first = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), fold);
+        __m128i last  = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3)), fold);
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, a), _mm_cmpeq_epi8(last, a)));
+        while (mask) {
+            int i = __builtin_ctz(mask);
+            if (IsArkaMarker(p + i)) return p + i;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    return FindArkaMarkerScalar(p, end);
+}
+
+__attribute__((target("avx2")))
+inline const char *FindArkaMarkerAVX2(const char *p, const char *end){
+    const __m256i fold = _mm256_set1_epi8(0x20);
+    const __m256i a    = _mm256_set1_epi8('a');
+    while (end - p >= 32 + 3) {
+        __m256i first = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), fold);
+        __m256i last  = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 3)), fold);
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first, a), _mm256_cmpeq_epi8(last, a)));
+        while (mask) {
+            int i = __builtin_ctz(mask);
+            if (IsArkaMarker(p + i)) return p + i;
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    return FindArkaMarkerSSE2(p, end);
+}
+#endif
+
+// Marker position in [begin, end), or nullptr if there is none.
+inline const char *FindArkaMarker(const char *begin, const char *end){
+#ifdef ARKA_SIMD_X86
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    return hasAVX2 ? FindArkaMarkerAVX2(begin, end) : FindArkaMarkerSSE2(begin, end);
+#else
+    return FindArkaMarkerScalar(begin, end);
+#endif
+}
+
+// Calls fn(marker, lineEnd) for every line of [begin, end) that carries the
+// marker. Everything else is skipped at the speed of FindArkaMarker, so this
+// replaces grep on a raw log.RAWtoALL as well as reading a grepped file.
+template <typename Fn>
+inline void ScanArkaLines(const char *begin, const char *end, Fn fn){
+    const char *p = begin;
+    while (const char *marker = FindArkaMarker(p, end)) {
+        const char *eol = static_cast<const char *>(memchr(marker, '\n', end - marker));
+        if (!eol) {
+            fn(marker, end);
+            return;
+        }
+        fn(marker, eol);
+        p = eol + 1;
+    }
+}
+
+// Parses one line [begin, end) without its trailing newline. The first two
+// tokens (time stamp and the "Arka" name) are skipped exactly as the
+// ifstream reader in MakeTree.C does. Returns false for malformed lines.
+inline bool ParseArkaLine(const char *begin, const char *end, ArkaHit &hit){
+    return ParseArkaFields(SkipToken(SkipToken(begin, end), end), end, hit);
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ARKASTATS_H
+#define ARKASTATS_H
+
+// Per-stage timing and counters of a conversion, written as a JSON summary
+// (MakeTree's stats=<file> option, MakeTreeBatch -s). The stages are
+//   read   inflating a tarball (a mapped file is paged in during parse)
+//   parse  marker scan and field parsing, or copying .arkb records
+//   fill   TTree::Fill / RNTuple fill, including the compression of the
+//          baskets that fill up on the way
+//   close  writing the last baskets, indices and file headers
+//   merge  joining the outputs (MakeTreeBatch and mt only)
+// CPU times are those of the converting thread, the batch total that of the
+// process; peak RSS is always the process's.
+
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+inline double ArkaWallSeconds(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+inline double ArkaThreadCpuSeconds(){
+    timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+inline double ArkaProcessCpuSeconds(){
+    timespec t;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+    return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+inline long ArkaPeakRssKb(){
+    rusage usage;
+    return getrusage(RUSAGE_SELF, &usage) == 0 ? usage.ru_maxrss : 0;
+}
+
+// Wall and CPU time summed over the intervals between Start() and Stop().
+struct ArkaStageTimer {
+    double wall = 0, cpu = 0;
+
+    void Start(){
+        fWall = ArkaWallSeconds();
+        fCpu = ArkaThreadCpuSeconds();
+    }
+    void Stop(){
+        wall += ArkaWallSeconds() - fWall;
+        cpu += ArkaThreadCpuSeconds() - fCpu;
+    }
+    void Add(const ArkaStageTimer &other){
+        wall += other.wall;
+        cpu += other.cpu;
+    }
+
+private:
+    double fWall = 0, fCpu = 0;
+};
+
+// What ForEachArkaHit saw of one input.
+struct ArkaInputStats {
+    ArkaStageTimer     read, parse;     // parse still includes the caller's fn, see ConvertFile
+    unsigned long long bytesIn = 0;     // size of the input file
+    unsigned long long bytesScanned = 0; // text scanned, log.RAWtoALL inflated for a tarball
+    unsigned long long linesScanned = 0;
+    unsigned long long linesMarked = 0;  // lines carrying the "Arka" marker
+    unsigned long long linesAccepted = 0; // of those, parsed into a hit
+
+    void Add(const ArkaInputStats &other){
+        read.Add(other.read);
+        parse.Add(other.parse);
+        bytesIn += other.bytesIn;
+        bytesScanned += other.bytesScanned;
+        linesScanned += other.linesScanned;
+        linesMarked += other.linesMarked;
+        linesAccepted += other.linesAccepted;
+    }
+};
+
+// One converted input.
+struct ArkaFileStats {
+    std::string              input;
+    std::vector<std::string> outputs;
+    long long                hits = -1;
+    ArkaInputStats           in;
+    ArkaStageTimer           fill, close, merge;
+    unsigned long long       bytesOut = 0;   // on disk, all outputs
+    unsigned long long       treeBytes = 0;  // uncompressed baskets (TTree only)
+    unsigned long long       zipBytes = 0;   // compressed baskets (TTree only)
+    long                     peakRssKb = 0;
+
+    double CompressionRatio() const { return zipBytes ? double(treeBytes) / zipBytes : 0; }
+};
+
+inline std::string ArkaJsonString(const std::string &s){
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "\\u%04x", c);
+            out += hex;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+inline void WriteStageJson(std::FILE *out, const char *name, const ArkaStageTimer &timer, bool last = false){
+    std::fprintf(out, "\"%s\": {\"wall\": %.6f, \"cpu\": %.6f}%s", name, timer.wall, timer.cpu, last ? "" : ", ");
+}
+
+inline void WriteFileStatsJson(std::FILE *out, const ArkaFileStats &file){
+    std::fprintf(out, "    {\"input\": %s, \"outputs\": [", ArkaJsonString(file.input).c_str());
+    for (size_t i = 0; i < file.outputs.size(); i++)
+        std::fprintf(out, "%s%s", i ? ", " : "", ArkaJsonString(file.outputs[i]).c_str());
+    double wall = file.in.read.wall + file.in.parse.wall + file.fill.wall + file.close.wall + file.merge.wall;
+    std::fprintf(out, "], \"hits\": %lld,\n     \"bytes_in\": %llu, \"bytes_scanned\": %llu, \"bytes_out\": %llu, "
+                      "\"tree_bytes\": %llu, \"zip_bytes\": %llu, \"compression_ratio\": %.3f,\n"
+                      "     \"lines_scanned\": %llu, \"lines_marked\": %llu, \"lines_accepted\": %llu, "
+                      "\"peak_rss_kb\": %ld, \"hits_per_s\": %.0f,\n     \"stages\": {",
+                 file.hits, file.in.bytesIn, file.in.bytesScanned, file.bytesOut, file.treeBytes, file.zipBytes,
+                 file.CompressionRatio(), file.in.linesScanned, file.in.linesMarked, file.in.linesAccepted,
+                 file.peakRssKb, wall > 0 && file.hits > 0 ? file.hits / wall : 0.);
+    WriteStageJson(out, "read", file.in.read);
+    WriteStageJson(out, "parse", file.in.parse);
+    WriteStageJson(out, "fill", file.fill);
+    WriteStageJson(out, "close", file.close);
+    WriteStageJson(out, "merge", file.merge, true);
+    std::fprintf(out, "}}");
+}
+
+// {"files": [...], "merge": {...}, "total": {...}}; merge and total are the
+// batch's own stages, a single conversion leaves them zero.
+inline bool WriteStatsJson(const char *path, const std::vector<ArkaFileStats> &files,
+                           const ArkaStageTimer &merge = ArkaStageTimer(),
+                           const ArkaStageTimer &total = ArkaStageTimer()){
+    std::FILE *out = std::fopen(path, "w");
+    if (!out) return false;
+    std::fprintf(out, "{\n  \"files\": [\n");
+    for (size_t i = 0; i < files.size(); i++) {
+        WriteFileStatsJson(out, files[i]);
+        std::fprintf(out, "%s\n", i + 1 < files.size() ? "," : "");
+    }
+    std::fprintf(out, "  ],\n  ");
+    WriteStageJson(out, "merge", merge, true);
+    std::fprintf(out, ",\n  \"total\": {\"wall\": %.6f, \"cpu\": %.6f, \"peak_rss_kb\": %ld}\n}\n",
+                 total.wall, total.cpu, ArkaPeakRssKb());
+    return std::fclose(out) == 0;
+}
+
+#endif
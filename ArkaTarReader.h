@@ -0,0 +1,153 @@
+#ifndef ARKATARREADER_H
+#define ARKATARREADER_H
+
+// Streaming reader for the grid job-log tarballs (.tgz). The gzip stream is
+// inflated by zlib and the tar headers are walked in place, so a member such
+// as <dir>/log.RAWtoALL can be read without unpacking anything to disk.
+// Memory use is bounded by the zlib buffer and the caller's block buffer.
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+class TarGzReader {
+public:
+    explicit TarGzReader(const char *path) : fIn(gzopen(path, "rb")), fRemaining(0), fPadding(0) {
+        if (fIn) gzbuffer(fIn, 1 << 20);
+    }
+    ~TarGzReader() {
+        if (fIn) gzclose(fIn);
+    }
+    TarGzReader(const TarGzReader &) = delete;
+    TarGzReader &operator=(const TarGzReader &) = delete;
+
+    bool IsOpen() const { return fIn != nullptr; }
+    const std::string &MemberName() const { return fName; }
+
+    // Moves to the next regular file whose name ends with suffix, skipping
+    // everything in between. Returns false at the end of the archive.
+    bool NextMember(const char *suffix) {
+        if (!fIn) return false;
+        if (!Skip(fRemaining + fPadding)) return false;
+        fRemaining = fPadding = 0;
+        std::string longName;
+        char header[512];
+        while (gzread(fIn, header, 512) == 512) {
+            if (header[0] == '\0') return false; // end-of-archive block
+            long long size = HeaderSize(header + 124);
+            if (size < 0) return false;
+            long long padding = (512 - size % 512) % 512;
+            char type = header[156];
+            if (type == 'L' || type == 'x') {
+                // GNU long name or pax extended header: the name is in the data,
+                // which is a few hundred bytes at most unless the archive is corrupt
+                if (size > kMaxExtendedHeader) return false;
+                std::string data(size, '\0');
+                if (gzread(fIn, &data[0], size) != size || !Skip(padding)) return false;
+                longName = type == 'L' ? std::string(data.c_str()) : PaxPath(data);
+                continue;
+            }
+            if (!longName.empty()) {
+                fName.swap(longName);
+                longName.clear();
+            } else {
+                fName = HeaderName(header);
+            }
+            bool isFile = type == '0' || type == '\0';
+            if (isFile && EndsWith(fName, suffix)) {
+                fRemaining = size;
+                fPadding = padding;
+                return true;
+            }
+            if (!Skip(size + padding)) return false;
+        }
+        return false;
+    }
+
+    // Reads up to n bytes of the current member; 0 at its end, -1 on error.
+    long long Read(char *buf, size_t n) {
+        if (fRemaining == 0) return 0;
+        if ((long long)n > fRemaining) n = fRemaining;
+        int got = gzread(fIn, buf, n);
+        if (got <= 0) return -1;
+        fRemaining -= got;
+        return got;
+    }
+
+private:
+    static const long long kMaxExtendedHeader = 1 << 20;
+
+    bool Skip(long long n) {
+        char scratch[1 << 16];
+        while (n > 0) {
+            int chunk = n > (long long)sizeof(scratch) ? sizeof(scratch) : n;
+            if (gzread(fIn, scratch, chunk) != chunk) return false;
+            n -= chunk;
+        }
+        return true;
+    }
+
+    // octal, or GNU base-256 for members above 8 GB
+    static long long HeaderSize(const char *field) {
+        if ((unsigned char)field[0] & 0x80) {
+            long long size = 0;
+            for (int i = 1; i < 12; i++) size = (size << 8) | (unsigned char)field[i];
+            return size;
+        }
+        return strtoll(std::string(field, strnlen(field, 12)).c_str(), nullptr, 8);
+    }
+
+    static std::string HeaderName(const char *header) {
+        std::string name(header, strnlen(header, 100));
+        const char *prefix = header + 345; // ustar prefix field
+        if (memcmp(header + 257, "ustar", 5) == 0 && prefix[0] != '\0')
+            name = std::string(prefix, strnlen(prefix, 155)) + "/" + name;
+        return name;
+    }
+
+    // pax records are "<length> <key>=<value>\n"
+    static std::string PaxPath(const std::string &data) {
+        size_t pos = data.find(" path=");
+        if (pos == std::string::npos) return std::string();
+        pos += 6;
+        return data.substr(pos, data.find('\n', pos) - pos);
+    }
+
+    static bool EndsWith(const std::string &name, const char *suffix) {
+        size_t n = strlen(suffix);
+        return name.size() >= n && name.compare(name.size() - n, n, suffix) == 0;
+    }
+
+    gzFile      fIn;
+    std::string fName;
+    long long   fRemaining;
+    long long   fPadding;
+};
+
+// Calls fn(begin, end) on consecutive blocks of the current member, each
+// cut just after a newline so that no line is split between two calls.
+// A line longer than the whole buffer is passed on in pieces.
+template <typename Fn>
+bool ForEachBlock(TarGzReader &in, Fn fn, size_t bufferSize = 1 << 22){
+    std::vector<char> buffer(bufferSize);
+    size_t kept = 0;
+    while (true) {
+        long long got = in.Read(buffer.data() + kept, bufferSize - kept);
+        if (got < 0) return false;
+        char *begin = buffer.data();
+        char *end = begin + kept + got;
+        if (got == 0) {
+            if (kept) fn(begin, end);
+            return true;
+        }
+        char *cut = static_cast<char *>(memrchr(begin, '\n', end - begin));
+        cut = cut ? cut + 1 : end;
+        fn(begin, cut);
+        kept = end - cut;
+        memmove(begin, cut, kept);
+    }
+}
+
+#endif
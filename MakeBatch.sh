@@ -0,0 +1,11 @@
+#! /bin/bash
+#### builds the MakeTreeBatch executable from MakeTreeBatch.cxx and MakeTree.C
+
+#### from ROOT 6.30 on MakeTree.C has the RNTuple writer, which is not in root-config --libs
+extra=""
+version=$(root-config --version | tr '/' '.')
+if [ "$(echo $version | awk -F. '{print ($1 * 100 + $2 >= 630)}')" = "1" ]; then
+    extra="-lROOTNTuple"
+fi
+
+g++ -O2 MakeTreeBatch.cxx -o MakeTreeBatch $(root-config --cflags --libs) $extra -lz -lpthread
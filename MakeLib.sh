@@ -1,6 +1,7 @@
 #! /bin/bash
 
 root -l -b << EOF
+gSystem->AddLinkedLibs("-lz")
 .L MakeTree.C++
 .q
 EOF
\ No newline at end of file
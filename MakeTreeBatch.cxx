@@ -0,0 +1,402 @@
+// Converts many logs or tarballs in one process, see usage below.
+// Build with MakeBatch.sh. Every input is converted by ConvertFile() from
+// MakeTree.C, so the outputs are the same as from MakeTree(), but ROOT and
+// the converter are loaded once for the whole list instead of once per file.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <glob.h>
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <sys/stat.h>
+#include "MakeTree.C"
+
+// A fixed set of tasks spread over one deque per worker. A worker takes from
+// the front of its own deque and, once that is empty, steals from the back
+// of the others, so a few very large logs do not leave the other threads idle.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(unsigned nThreads) : fQueues(nThreads), fNext(0) {}
+
+    void Push(function<void()> task){
+        Queue &queue = fQueues[fNext++ % fQueues.size()];
+        lock_guard<mutex> lock(queue.fMutex);
+        queue.fTasks.push_back(move(task));
+    }
+
+    void Run(){
+        vector<thread> threads;
+        for(unsigned i = 0; i < fQueues.size(); i++) threads.emplace_back([this, i](){ Work(i); });
+        for(auto &t : threads) t.join();
+    }
+
+private:
+    struct Queue {
+        mutex                   fMutex;
+        deque<function<void()>> fTasks;
+    };
+
+    bool Take(unsigned i, bool front, function<void()> &task){
+        Queue &queue = fQueues[i];
+        lock_guard<mutex> lock(queue.fMutex);
+        if(queue.fTasks.empty()) return false;
+        if(front){
+            task = move(queue.fTasks.front());
+            queue.fTasks.pop_front();
+        } else {
+            task = move(queue.fTasks.back());
+            queue.fTasks.pop_back();
+        }
+        return true;
+    }
+
+    void Work(unsigned self){
+        function<void()> task;
+        while (true){
+            bool found = Take(self, true, task);
+            for(unsigned k = 1; !found && k < fQueues.size(); k++)
+                found = Take((self + k) % fQueues.size(), false, task);
+            if(!found) return;
+            task();
+        }
+    }
+
+    vector<Queue> fQueues;
+    size_t        fNext;
+};
+
+double Seconds(chrono::steady_clock::time_point start){
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 64-bit content hash of a whole file: four multiply-xorshift lanes over
+// 8-byte words of the mapped file, so it runs at memory speed. It only has
+// to notice a changed or replaced input, it is not meant against tampering.
+ULong64_t HashFile(const char *path){
+    const ULong64_t kMul = 0x9e3779b97f4a7c15ULL;
+    MappedFile file(path);
+    const char *p = file.begin(), *end = file.end();
+    ULong64_t lane[4] = {1, 2, 3, 4};
+    for(; end - p >= 32; p += 32){
+        for(int i = 0; i < 4; i++){
+            ULong64_t word;
+            memcpy(&word, p + 8 * i, 8);
+            lane[i] = (lane[i] ^ word) * kMul;
+            lane[i] ^= lane[i] >> 29;
+        }
+    }
+    ULong64_t hash = file.size();
+    for(; p < end; p++) hash = (hash ^ (unsigned char)*p) * 0x100000001b3ULL;
+    for(int i = 0; i < 4; i++){
+        hash = (hash ^ lane[i]) * kMul;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+// What a run made of one input, one line of <outputStem>.state: its content
+// hash, size and modification time, its number N (<outputStem>_N.root, kept
+// for as long as the input is listed), the hits and output files written,
+// and the hash of the content that is in <outputStem>_All.root (0 if none).
+struct InputState {
+    TString         input;
+    Int_t           id = 0;
+    ULong64_t       hash = 0, mergedHash = 0;
+    Long64_t        size = -1, mtime = -1, hits = -1;
+    vector<TString> outputs;
+};
+
+Bool_t Exists(const char *path){
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+// The first line holds the MakeTree options of the run, outputs made with
+// other options are not reused. The other lines are tab-separated fields:
+// id, hash, merged hash, size, mtime, hits, the number of outputs, the
+// outputs and the input, so that paths may hold anything but tabs and newlines.
+Bool_t LoadState(TString path, TString &options, vector<InputState> &states){
+    ifstream in(path.Data());
+    string line;
+    if(!getline(in, line) || line.compare(0, 8, "options\t") != 0) return kFALSE;
+    options = line.substr(8).c_str();
+    while (getline(in, line)){
+        vector<string> fields;
+        for(size_t first = 0;;){
+            size_t last = line.find('\t', first);
+            fields.push_back(line.substr(first, last == string::npos ? string::npos : last - first));
+            if(last == string::npos) break;
+            first = last + 1;
+        }
+        if(fields.size() < 8) continue;
+        size_t nOutputs = strtoul(fields[6].c_str(), nullptr, 10);
+        if(fields.size() != 8 + nOutputs || fields.back().empty()) continue;
+        InputState state;
+        state.id = atoi(fields[0].c_str());
+        state.hash = strtoull(fields[1].c_str(), nullptr, 16);
+        state.mergedHash = strtoull(fields[2].c_str(), nullptr, 16);
+        state.size = atoll(fields[3].c_str());
+        state.mtime = atoll(fields[4].c_str());
+        state.hits = atoll(fields[5].c_str());
+        for(size_t k = 0; k < nOutputs; k++) state.outputs.push_back(fields[7 + k].c_str());
+        state.input = fields.back().c_str();
+        states.push_back(state);
+    }
+    return kTRUE;
+}
+
+// Written next to the file and renamed over it, so an interrupted run leaves the old state.
+Bool_t SaveState(TString path, TString options, const vector<InputState> &states){
+    TString temporary = path + ".tmp";
+    {
+        ofstream out(temporary.Data());
+        out << "options\t" << options << '\n';
+        for(auto &state : states){
+            out << state.id << '\t' << hex << state.hash << '\t' << state.mergedHash << dec << '\t' << state.size
+                << '\t' << state.mtime << '\t' << state.hits << '\t' << state.outputs.size();
+            for(auto &output : state.outputs) out << '\t' << output;
+            out << '\t' << state.input << '\n';
+        }
+        if(!out.good()) return kFALSE;
+    }
+    return gSystem->Rename(temporary, path) == 0;
+}
+
+void Usage(){
+    cout << "usage: MakeTreeBatch [-j threads] [-o outputStem] [-O \"MakeTree options\"] [-n | -M] [-f] [-s stats.json] [-l fileList] [files or 'globs' ...]\n"
+         << "  every input becomes <outputStem>_<N>.root, N counting from 1 in the order the inputs were first seen,\n"
+         << "  and all of them are then fast-merged into <outputStem>_All.root (not with -n)\n"
+         << "  <outputStem>.state records what was converted: a rerun only converts new or changed inputs\n"
+         << "  and appends new outputs to <outputStem>_All.root; -f ignores it and converts everything\n"
+         << "  -s writes time, CPU, bytes, lines and peak RSS per stage and input as JSON (ArkaStats.h)\n"
+         << "  -M only merges, the inputs being existing outputs, with a parallel tree reduction\n"
+         << "  -j 0 (default) uses all cores, -l reads one input per line (e.g. file75V.txt)\n"
+         << "  -O takes the MakeTree options, e.g. -O \"compact comp=zstd:5 basket=256k flush=50mb\"\n"
+         << "  with -O cache=<dir> input N is cached in <dir>/N, joined into <dir> itself with the merge" << endl;
+}
+
+int main(int argc, char **argv){
+    unsigned nThreads = 0;
+    bool merge = true, mergeOnly = false, force = false;
+    TString outStem = "out", options, statsFile;
+    vector<TString> inputs;
+    for(int i = 1; i < argc; i++){
+        TString arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if(arg == "-j" && hasValue) nThreads = atoi(argv[++i]);
+        else if(arg == "-o" && hasValue) outStem = argv[++i];
+        else if(arg == "-O" && hasValue) options = argv[++i];
+        else if(arg == "-n") merge = false;
+        else if(arg == "-M") mergeOnly = true;
+        else if(arg == "-f") force = true;
+        else if(arg == "-s" && hasValue) statsFile = argv[++i];
+        else if(arg == "-l" && hasValue){
+            // one path per line, spaces included; blank lines are skipped
+            ifstream list(argv[++i]);
+            string line;
+            while (getline(list, line)){
+                size_t last = line.find_last_not_of(" \t\r");
+                if(last == string::npos) continue;
+                inputs.push_back(line.substr(0, last + 1).c_str());
+            }
+        }
+        else if(arg == "-h" || arg == "--help"){ Usage(); return 0; }
+        else {
+            glob_t matches;
+            if(glob(arg, GLOB_NOCHECK, nullptr, &matches) == 0)
+                for(size_t k = 0; k < matches.gl_pathc; k++) inputs.push_back(matches.gl_pathv[k]);
+            globfree(&matches);
+        }
+    }
+    TString mergedName = outStem + "_All.root";
+    inputs.erase(remove(inputs.begin(), inputs.end(), mergedName), inputs.end());
+    if(inputs.empty()){ Usage(); return 1; }
+    if(nThreads == 0) nThreads = max(1u, thread::hardware_concurrency());
+    nThreads = min<unsigned>(nThreads, inputs.size());
+
+    ROOT::EnableThreadSafety();
+    auto start = chrono::steady_clock::now();
+    Double_t startCpu = ArkaProcessCpuSeconds();
+
+    if(mergeOnly){
+        Bool_t merged = MergeTrees(inputs, mergedName, nThreads);
+        cout << (merged ? "Merged " : "error merging ") << inputs.size() << " files into " << mergedName << " in "
+             << Seconds(start) << " s on " << nThreads << " threads" << endl;
+        return merged ? 0 : 1;
+    }
+
+    // inputs keep their number and outputs from the last run; new ones are numbered after them
+    TString statePath = outStem + ".state", stateOptions;
+    vector<InputState> previous;
+    Bool_t incremental = !force && LoadState(statePath, stateOptions, previous);
+    if(incremental && stateOptions != options){
+        cout << "options differ from the last run (\"" << stateOptions << "\"), converting everything" << endl;
+        incremental = kFALSE;
+    }
+    if(!incremental) previous.clear();
+    map<string, size_t> known;
+    Int_t nextId = 1;
+    for(size_t i = 0; i < previous.size(); i++){
+        known[previous[i].input.Data()] = i;
+        nextId = max(nextId, previous[i].id + 1);
+    }
+    vector<InputState> states(inputs.size());
+    vector<char> listed(previous.size(), 0);
+    for(size_t k = 0; k < inputs.size(); k++){
+        auto it = known.find(inputs[k].Data());
+        if(it != known.end() && !listed[it->second]){
+            states[k] = previous[it->second];
+            listed[it->second] = 1;
+        } else {
+            states[k].input = inputs[k];
+            states[k].id = nextId++;
+        }
+    }
+
+    // largest inputs first, so that the long conversions start early
+    vector<size_t> order(inputs.size());
+    vector<Long64_t> sizes(inputs.size(), 0);
+    vector<Long64_t> mtimes(inputs.size(), 0);
+    for(size_t k = 0; k < inputs.size(); k++){
+        struct stat st;
+        if(stat(inputs[k], &st) == 0){
+            sizes[k] = st.st_size;
+            mtimes[k] = st.st_mtime;
+        }
+        order[k] = k;
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){ return sizes[a] > sizes[b]; });
+
+    // one column cache per input, joined in input order with the merge and
+    // kept, so that a later run can join them again without converting
+    TString cacheDir;
+    Bool_t cache = HasOption(options, "cache", &cacheDir) && !cacheDir.IsNull();
+    auto cacheOf = [&](size_t k){ return TString::Format("%s/%d", cacheDir.Data(), states[k].id); };
+
+    mutex printMutex;
+    vector<Long64_t> nHits(inputs.size(), -1);
+    vector<char> skipped(inputs.size(), 0);
+    vector<ArkaFileStats> stats(statsFile.IsNull() ? 0 : inputs.size());
+    WorkStealingPool pool(nThreads);
+    for(size_t k : order){
+        pool.Push([&, k](){
+            auto fileStart = chrono::steady_clock::now();
+            InputState &state = states[k];
+            // an input whose outputs are still there is only hashed if its size or time changed
+            Bool_t converted = state.hits >= 0 && !state.outputs.empty() &&
+                               (!cache || Exists(ColumnPath(cacheOf(k).Data(), "event_number").c_str()));
+            for(auto &output : state.outputs) converted = converted && Exists(output);
+            ULong64_t hash = state.hash;
+            if(!converted || sizes[k] != state.size || mtimes[k] != state.mtime) hash = HashFile(inputs[k]);
+            if(converted && hash == state.hash && sizes[k] == state.size){
+                state.mtime = mtimes[k];
+                nHits[k] = state.hits;
+                skipped[k] = 1;
+                return;
+            }
+            TString outFileName = TString::Format("%s_%d.root", outStem.Data(), state.id);
+            state.outputs.clear();
+            nHits[k] = ConvertFile(inputs[k], outFileName, cache ? WithOption(options, "cache", cacheOf(k)) : options,
+                                   &state.outputs, stats.empty() ? nullptr : &stats[k]);
+            state.hash = hash;
+            state.size = sizes[k];
+            state.mtime = mtimes[k];
+            state.hits = nHits[k];
+            lock_guard<mutex> lock(printMutex);
+            if(nHits[k] < 0) cout << "error converting " << inputs[k] << endl;
+            else cout << inputs[k] << " -> " << outFileName << ": " << nHits[k] << " hits in "
+                      << Seconds(fileStart) << " s" << endl;
+        });
+    }
+    pool.Run();
+
+    Long64_t total = 0;
+    Int_t nFailed = 0, nSkipped = 0;
+    for(size_t k = 0; k < inputs.size(); k++){
+        if(nHits[k] < 0) nFailed++;
+        else total += nHits[k];
+        nSkipped += skipped[k];
+    }
+    cout << "Files done: " << inputs.size() - nFailed << " of " << inputs.size() << " (" << nSkipped
+         << " unchanged since the last run), " << total << " hits in " << Seconds(start) << " s on " << nThreads
+         << " threads" << endl;
+
+    Int_t status = nFailed ? 1 : 0;
+    Bool_t mergeFailed = kFALSE;
+    ArkaStageTimer mergeTimer;
+    if(merge){
+        auto mergeStart = chrono::steady_clock::now();
+        mergeTimer.Start();
+        // appending is enough if the merged file holds exactly the listed
+        // inputs' current content, apart from inputs that are new to it
+        size_t nMerged = 0, nStillMerged = 0;
+        for(auto &state : previous) if(state.mergedHash) nMerged++;
+        for(size_t k = 0; k < inputs.size(); k++)
+            if(states[k].mergedHash && nHits[k] >= 0 && states[k].mergedHash == states[k].hash) nStillMerged++;
+        Bool_t append = incremental && nMerged > 0 && nStillMerged == nMerged && Exists(mergedName);
+
+        vector<TString> files, caches;
+        for(size_t k = 0; k < inputs.size(); k++){
+            if(nHits[k] < 0 || (append && states[k].mergedHash)) continue;
+            files.insert(files.end(), states[k].outputs.begin(), states[k].outputs.end());
+            caches.push_back(cacheOf(k));
+        }
+        if(append && files.empty()){
+            cout << mergedName << " is up to date" << endl;
+        } else {
+            // after a conversion a single fast-clone pass is the least copying
+            if(append && !AppendFiles(files, mergedName)){
+                cout << "cannot append to " << mergedName << ", merging all files again" << endl;
+                append = kFALSE;
+                files.clear();
+                caches.clear();
+                for(size_t k = 0; k < inputs.size(); k++){
+                    if(nHits[k] < 0) continue;
+                    files.insert(files.end(), states[k].outputs.begin(), states[k].outputs.end());
+                    caches.push_back(cacheOf(k));
+                }
+            }
+            if(!append && !MergeFiles(files, mergedName)){
+                cout << "error merging into " << mergedName << endl;
+                mergeFailed = kTRUE;
+            } else {
+                cout << (append ? "Appended " : "Merged ") << files.size() << " files into " << mergedName << " in "
+                     << Seconds(mergeStart) << " s, total " << Seconds(start) << " s" << endl;
+            }
+            if(!mergeFailed && cache && !(append ? AppendColumnCaches(caches, cacheDir, HasOption(options, "compact"))
+                                                 : MergeColumnCaches(caches, cacheDir, HasOption(options, "compact"), kFALSE))){
+                cout << "error joining the column caches into " << cacheDir << endl;
+                mergeFailed = kTRUE;
+            }
+        }
+        mergeTimer.Stop();
+        // after a failed merge nothing counts as merged, the next run merges everything again
+        for(size_t k = 0; k < inputs.size(); k++) states[k].mergedHash = nHits[k] < 0 || mergeFailed ? 0 : states[k].hash;
+        if(mergeFailed) status = 1;
+    } else {
+        // still in the merged file, the next merge has to drop them
+        for(size_t i = 0; i < previous.size(); i++)
+            if(!listed[i] && previous[i].mergedHash) states.push_back(previous[i]);
+    }
+    if(!stats.empty()){
+        // inputs skipped as unchanged are left out
+        vector<ArkaFileStats> converted;
+        for(size_t k = 0; k < inputs.size(); k++) if(!skipped[k]) converted.push_back(stats[k]);
+        ArkaStageTimer total;
+        total.wall = Seconds(start);
+        total.cpu = ArkaProcessCpuSeconds() - startCpu;
+        if(!WriteStatsJson(statsFile, converted, mergeTimer, total)){
+            cout << "error writing " << statsFile << endl;
+            status = 1;
+        }
+    }
+    if(!SaveState(statePath, options, states)){
+        cout << "error writing " << statePath << endl;
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,96 @@
+#ifndef SCTLORENTZGEOMETRY_H
+#define SCTLORENTZGEOMETRY_H
+
+// The local axes of every SCT wafer in global coordinates, as a structure of
+// arrays by wafer hash, for the track angles of SCTLorentzMonTool. Filled
+// from the detector elements when the geometry may have changed (new run or
+// lumi block, alignment update), so that a hit no longer looks up its element
+// and axes: the angles are three dot products of cached floats.
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace SCTLorentz {
+
+class WaferAxes {
+public:
+    void Resize(unsigned int nWafers){
+        for (auto *v : {&fNx, &fNy, &fNz, &fPx, &fPy, &fPz, &fEx, &fEy, &fEz}) v->assign(nWafers, 0.f);
+        fValid.assign(nWafers, 0);
+    }
+    unsigned int Size() const { return fValid.size(); }
+
+    void Set(unsigned int hash, const double normal[3], const double phiAxis[3], const double etaAxis[3]){
+        fNx[hash] = normal[0];
+        fNy[hash] = normal[1];
+        fNz[hash] = normal[2];
+        fPx[hash] = phiAxis[0];
+        fPy[hash] = phiAxis[1];
+        fPz[hash] = phiAxis[2];
+        fEx[hash] = etaAxis[0];
+        fEy[hash] = etaAxis[1];
+        fEz[hash] = etaAxis[2];
+        fValid[hash] = 1;
+    }
+    bool IsValid(unsigned int hash) const { return hash < fValid.size() && fValid[hash]; }
+
+    // Angles in degrees of the momentum p to the wafer normal, in the plane
+    // of the normal and the phi axis (phi) and of the normal and the eta axis
+    // (theta); +-90 if the momentum lies in the wafer plane. False if the
+    // wafer has no detector element.
+    bool Angles(unsigned int hash, const float p[3], float &theta, float &phi) const {
+        if (!IsValid(hash)) {
+            theta = phi = 90.f;
+            return false;
+        }
+        float pNormal = p[0] * fNx[hash] + p[1] * fNy[hash] + p[2] * fNz[hash];
+        float pPhi = p[0] * fPx[hash] + p[1] * fPy[hash] + p[2] * fPz[hash];
+        float pEta = p[0] * fEx[hash] + p[1] * fEy[hash] + p[2] * fEz[hash];
+        ToAngles(pNormal, pPhi, pEta, theta, phi);
+        return true;
+    }
+
+    // The same for the n hits of a track at once: hashes[i] and momentum
+    // px[i], py[i], pz[i]. ok[i] is 0 for a wafer without detector element.
+    // Returns the number of hits with angles.
+    unsigned int Angles(unsigned int n, const uint32_t *hashes, const float *px, const float *py, const float *pz,
+                        float *theta, float *phi, uint8_t *ok) const {
+        unsigned int nOk = 0;
+        for (unsigned int i = 0; i < n; i++) {
+            uint32_t h = hashes[i];
+            ok[i] = IsValid(h);
+            if (!ok[i]) {
+                theta[i] = phi[i] = 90.f;
+                continue;
+            }
+            float pNormal = px[i] * fNx[h] + py[i] * fNy[h] + pz[i] * fNz[h];
+            float pPhi = px[i] * fPx[h] + py[i] * fPy[h] + pz[i] * fPz[h];
+            float pEta = px[i] * fEx[h] + py[i] * fEy[h] + pz[i] * fEz[h];
+            ToAngles(pNormal, pPhi, pEta, theta[i], phi[i]);
+            nOk++;
+        }
+        return nOk;
+    }
+
+private:
+    static void ToAngles(float pNormal, float pPhi, float pEta, float &theta, float &phi){
+        const float toDegrees = 180. / M_PI;
+        if (pNormal != 0.f) {
+            phi = std::atan(pPhi / pNormal) * toDegrees;
+            theta = std::atan(pEta / pNormal) * toDegrees;
+        } else {
+            phi = pPhi < 0.f ? -90.f : 90.f;
+            theta = pEta < 0.f ? -90.f : 90.f;
+        }
+    }
+
+    std::vector<float>   fNx, fNy, fNz; // normal
+    std::vector<float>   fPx, fPy, fPz; // phi axis
+    std::vector<float>   fEx, fEy, fEz; // eta axis
+    std::vector<uint8_t> fValid;
+};
+
+}
+
+#endif
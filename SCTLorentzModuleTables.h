@@ -0,0 +1,242 @@
+#ifndef SCTLORENTZMODULETABLES_H
+#define SCTLORENTZMODULETABLES_H
+
+// Module lists of the SCT Lorentz angle monitoring, shared by
+// SCTLorentzMonTool and the offline filler (FillLorentzProfiles.C).
+
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace SCTLorentz {
+
+// The barrel wafers with <100> crystal orientation, as (layer, phi module,
+// eta module) triplets; all others are <111>. Should come from the database.
+constexpr int kLayer100[] = {
+    2, 2, 3, 2, 2, 2, 0, 2, 3, 2, 0, 2, 3, 2, 3, 2, 0, 2, 3, 0, 2, 0, 2, 3, 2, 2, 2, 0, 0, 0, 0, 0, 0, 3, 0, 3, 2, 0, 2,
+    2, 0, 3, 3, 3, 0, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 3, 3, 2, 2, 2, 2, 2, 3, 3, 2, 3, 2, 2, 2, 3, 3, 3, 2, 2, 2, 2, 3, 3,
+    2, 3, 2, 3, 3, 2, 3, 2, 2, 2, 2, 2, 2, 2
+};
+constexpr int kPhi100[] = {
+    29, 29, 6, 13, 23, 13, 14, 29, 9, 29, 14, 29, 9, 29, 39, 32, 21, 32, 13, 22, 32, 22, 32, 13, 32, 32, 32, 20, 20, 20,
+    20, 20, 20, 13, 21, 17, 33, 5, 33, 33, 31, 6, 19, 47, 21, 37, 37, 37, 37, 33, 37, 37, 24, 33, 33, 47, 19, 33, 33,
+    37, 37, 37, 55, 9, 38, 24, 37, 38, 8, 9, 9, 26, 38, 38, 38, 38, 39, 39, 38, 11, 45, 54, 54, 24, 31, 14, 47, 45, 47,
+    47, 47, 47
+};
+constexpr int kEta100[] = {
+    3, -4, -6, 2, 6, 3, -5, -1, 6, -2, -6, -5, 5, -3, 2, 6, -3, 5, 5, 3, 4, 2, 2, 2, -1, -3, -4, 1, -1, -2, -3, -4, 4,
+    -1, -5, 6, 2, 4, 3, 1, 6, -2, 6, 3, -6, -1, 2, 1, 3, -5, 4, 5, -3, -4, -3, -5, -2, -1, -2, -3, -2, -4, -3, 2, 3, -6,
+    -5, 4, 6, 1, -6, 1, 1, -5, -4, -3, -3, -5, -2, 1, 5, 5, 4, 4, 5, 4, -1, -5, 3, 4, 1, -5
+};
+constexpr unsigned int kN100 = sizeof(kLayer100) / sizeof(*kLayer100);
+
+static_assert(kN100 == sizeof(kPhi100) / sizeof(*kPhi100) && kN100 == sizeof(kEta100) / sizeof(*kEta100),
+              "Coordinate arrays for <100> wafers are not of equal length");
+
+// The same list as one bit per barrel wafer, built at compile time, so that
+// the per-hit check is a bounds test and a single load.
+constexpr int kNBarrelLayers100 = 4, kEtaMin100 = -6, kNEta100 = 13, kNPhi100 = 56;
+constexpr int kNWafer100Words = (kNBarrelLayers100 * kNEta100 * kNPhi100 + 63) / 64;
+
+constexpr int Wafer100Bit(int layer, int eta, int phi){
+    return (layer * kNEta100 + eta - kEtaMin100) * kNPhi100 + phi;
+}
+
+struct Wafer100Bitmap {
+    unsigned long long words[kNWafer100Words];
+};
+
+constexpr bool Wafer100InRange(int layer, int eta, int phi){
+    return layer >= 0 && layer < kNBarrelLayers100 && eta >= kEtaMin100 && eta < kEtaMin100 + kNEta100 && phi >= 0 &&
+           phi < kNPhi100;
+}
+
+constexpr bool Wafer100ListInRange(){
+    for (unsigned int i = 0; i < kN100; i++)
+        if (!Wafer100InRange(kLayer100[i], kEta100[i], kPhi100[i])) return false;
+    return true;
+}
+
+static_assert(Wafer100ListInRange(), "<100> wafer outside of the barrel bitmap");
+
+constexpr Wafer100Bitmap MakeWafer100Bitmap(){
+    Wafer100Bitmap bitmap{};
+    for (unsigned int i = 0; i < kN100; i++) {
+        int bit = Wafer100Bit(kLayer100[i], kEta100[i], kPhi100[i]);
+        bitmap.words[bit >> 6] |= 1ull << (bit & 63);
+    }
+    return bitmap;
+}
+
+constexpr Wafer100Bitmap kWafer100Bitmap = MakeWafer100Bitmap();
+
+inline bool IsWafer100(int layer, int eta, int phi){
+    if (!Wafer100InRange(layer, eta, phi)) return false;
+    int bit = Wafer100Bit(layer, eta, phi);
+    return kWafer100Bitmap.words[bit >> 6] >> (bit & 63) & 1;
+}
+
+// The linear scan over the list the tool used to do, kept as the reference
+// for BenchWaferLookup.
+inline bool IsWafer100Scan(int layer, int eta, int phi){
+    for (unsigned int i = 0; i < kN100; i++)
+        if (kLayer100[i] == layer && kEta100[i] == eta && kPhi100[i] == phi) return true;
+    return false;
+}
+
+// Modules with low and with high initial depletion voltage, as (eta module,
+// phi module) pairs on any layer and side, which is how
+// SCTLorentzMonTool::chooseModule() used to select them.
+constexpr int kLowVdepModules[][2] = {
+    {-6, 7}, {-6, 14}, {-6, 18}, {-6, 23}, {-6, 26},
+    {-5, 14}, {-5, 16}, {-5, 17}, {-5, 18}, {-5, 21}, {-5, 23}, {-5, 26}, {-5, 27},
+    {-4, 20}, {-4, 23}, {-4, 27}, {-4, 29},
+    {-3, 20}, {-3, 25}, {-3, 27},
+    {-2, 24}, {-2, 31},
+    {-1, 1}, {-1, 6}, {-1, 17}, {-1, 24}, {-1, 26}, {-1, 27}, {-1, 29},
+    {1, 6}, {1, 12}, {1, 20}, {1, 26}, {1, 27},
+    {2, 12}, {2, 16}, {2, 19}, {2, 22}, {2, 26},
+    {3, 3}, {3, 26},
+    {4, 5}, {4, 19}, {4, 20}, {4, 25}, {4, 26}, {4, 29},
+    {5, 0}, {5, 1}, {5, 12}, {5, 19}, {5, 21}, {5, 26},
+    {6, 1}, {6, 18}, {6, 25}, {6, 31}
+};
+constexpr int kHighVdepModules[][2] = {
+    {-6, 2}, {-6, 6}, {-6, 15}, {-6, 17},
+    {-5, 0}, {-5, 2}, {-5, 3}, {-5, 9}, {-5, 12}, {-5, 15},
+    {-4, 6}, {-4, 8}, {-4, 12}, {-4, 13}, {-4, 21}, {-4, 22}, {-4, 24}, {-4, 25}, {-4, 30}, {-4, 31},
+    {-3, 0}, {-3, 2}, {-3, 6}, {-3, 10}, {-3, 11}, {-3, 12}, {-3, 13}, {-3, 16}, {-3, 18}, {-3, 24}, {-3, 30},
+    {-2, 9}, {-2, 19}, {-2, 25}, {-2, 30},
+    {-1, 5}, {-1, 13},
+    {1, 3}, {1, 10}, {1, 13}, {1, 25},
+    {2, 10}, {2, 14}, {2, 25},
+    {3, 6}, {3, 7}, {3, 13}, {3, 14}, {3, 16}, {3, 27},
+    {4, 1}, {4, 2}, {4, 8}, {4, 17}, {4, 18},
+    {5, 13}, {5, 16}, {5, 22}, {5, 29}, {5, 30}, {5, 31},
+    {6, 6}, {6, 14}
+};
+
+// A wafer's identifier decoded once (the tool keeps one per wafer hash), so
+// that a hit does not extract the fields one by one: the offline numbering,
+// the module key of the hit records and ntuples (PackModuleKey in
+// ArkaHitRecord.h) and the category flags (ModuleCategories::Flags).
+struct WaferModule {
+    int8_t   bec, layer, eta, phi, side;
+    uint32_t moduleKey;
+    uint32_t flags;
+};
+
+// Named module categories, one bit each, so that a hit's module can be
+// tested against any of them with one mask once the flags of every module
+// are known (the tool keeps them per wafer hash). lowVdep, highVdep and
+// wafer100 are built in; more come from rules, one per line:
+//   <category> <bec> <layer> <eta module> <phi module> <side>
+// where * matches any value and # starts a comment, e.g.
+//   study1  0 2 * 33 *
+class ModuleCategories {
+public:
+    static constexpr int kAny = INT_MIN;
+    static constexpr int kMaxCategories = 32;
+
+    ModuleCategories(){
+        for (const auto &module : kLowVdepModules) AddRule("lowVdep", kAny, kAny, module[0], module[1], kAny);
+        for (const auto &module : kHighVdepModules) AddRule("highVdep", kAny, kAny, module[0], module[1], kAny);
+        for (unsigned int i = 0; i < kN100; i++) AddRule("wafer100", 0, kLayer100[i], kEta100[i], kPhi100[i], kAny);
+    }
+
+    // Bit of a category, -1 if there is none of that name.
+    int Category(const std::string &name) const {
+        for (size_t i = 0; i < fNames.size(); i++)
+            if (fNames[i] == name) return i;
+        return -1;
+    }
+    uint32_t Mask(const std::string &name) const {
+        int bit = Category(name);
+        return bit < 0 ? 0 : 1u << bit;
+    }
+    const std::vector<std::string> &Names() const { return fNames; }
+
+    bool AddRule(const std::string &name, int bec, int layer, int eta, int phi, int side){
+        int bit = Category(name);
+        if (bit < 0) {
+            if ((int)fNames.size() == kMaxCategories) return false;
+            bit = fNames.size();
+            fNames.push_back(name);
+        }
+        fRules.push_back({bit, {bec, layer, eta, phi, side}});
+        return true;
+    }
+
+    // One rule in the text form above; blank and comment lines are accepted
+    // and ignored. On failure error says why.
+    bool AddRule(const std::string &line, std::string &error){
+        std::istringstream in(line.substr(0, line.find('#')));
+        std::string name, fields[5];
+        if (!(in >> name)) return true;
+        int values[5];
+        for (int i = 0; i < 5; i++) {
+            if (!(in >> fields[i])) {
+                error = "expected <category> <bec> <layer> <eta> <phi> <side>: " + line;
+                return false;
+            }
+            if (fields[i] == "*") {
+                values[i] = kAny;
+                continue;
+            }
+            size_t end = 0;
+            try {
+                values[i] = std::stoi(fields[i], &end);
+            } catch (...) {
+                end = 0;
+            }
+            if (end != fields[i].size()) {
+                error = "not a number or *: " + fields[i] + " in " + line;
+                return false;
+            }
+        }
+        if (!AddRule(name, values[0], values[1], values[2], values[3], values[4])) {
+            error = "more than 32 module categories at " + line;
+            return false;
+        }
+        return true;
+    }
+
+    bool Load(const std::string &path, std::string &error){
+        std::ifstream in(path);
+        if (!in) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line))
+            if (!AddRule(line, error)) return false;
+        return true;
+    }
+
+    // The categories of one module, one bit per category.
+    uint32_t Flags(int bec, int layer, int eta, int phi, int side) const {
+        const int values[5] = {bec, layer, eta, phi, side};
+        uint32_t flags = 0;
+        for (const auto &rule : fRules) {
+            bool match = true;
+            for (int i = 0; i < 5 && match; i++) match = rule.values[i] == kAny || rule.values[i] == values[i];
+            if (match) flags |= 1u << rule.bit;
+        }
+        return flags;
+    }
+
+private:
+    struct Rule {
+        int bit;
+        int values[5]; // bec, layer, eta, phi, side
+    };
+    std::vector<std::string> fNames;
+    std::vector<Rule>        fRules;
+};
+
+}
+
+#endif
@@ -11,7 +11,12 @@
 #include "SCT_Monitoring/SCTLorentzMonTool.h"
 #include "deletePointers.h"
 #include "SCT_NameFormatter.h"
+#include "ArkaHitRecord.h"
+#include "SCTLorentzModuleTables.h"
+#include "SCTLorentzRegions.h"
+#include "SCTLorentzGeometry.h"
 #include <cmath>
+#include <map>
 #include <type_traits>
 
 #include "GaudiKernel/StatusCode.h"
@@ -21,10 +26,14 @@
 #include "TH2F.h"
 #include "TProfile2D.h"
 #include "TF1.h"
+#include "TTree.h"
+#include "RVersion.h"
 #include "DataModel/DataVector.h"
 #include "Identifier/Identifier.h"
+#include "Identifier/IdentifierHash.h"
 #include "InDetIdentifier/SCT_ID.h"
 #include "InDetReadoutGeometry/SCT_DetectorManager.h"
+#include "InDetReadoutGeometry/SiDetectorElement.h"
 #include "TrkTrack/TrackCollection.h"
 #include "InDetRIO_OnTrack/SiClusterOnTrack.h"
 #include "InDetPrepRawData/SiCluster.h"
@@ -56,6 +65,22 @@ namespace{//anonymous namespace for functions at file scope
     }
     return result;
   }
+
+  /// the fields of one "Arka" printout line as a fixed-size binary record, the wafer as its cached module key
+  ArkaHitRecord makeHitRecord(uint64_t event_number, float pT, float trkEta, float trackPhi, float phiToWafer,
+                              int nStrip, const SCTLorentz::WaferModule &module, float charge){
+    ArkaHitRecord record;
+    record.event_number = event_number;
+    record.pT = pT;
+    record.trkEta = trkEta;
+    record.trkPhi = trackPhi;
+    record.phiToWafer = phiToWafer;
+    record.moduleKey = module.moduleKey;
+    record.nStrip = nStrip;
+    record.charge = charge;
+    record.reserved = 0;
+    return record;
+  }
 }//namespace end
 // ====================================================================================================
 /** Constructor, calls base class constructor with parameters
@@ -67,18 +92,11 @@ namespace{//anonymous namespace for functions at file scope
 SCTLorentzMonTool::SCTLorentzMonTool(const string &type, const string &name,
                                      const IInterface *parent) : SCTMotherTrigMonTool(type, name, parent),
 								 m_trackToVertexTool("Reco::TrackToVertex", this), // for TrackToVertexTool
-								 m_phiVsNstrips{},
-								 m_phiVsNstrips_075{},
-								 m_phiVsNstrips_15{},
-								 m_phiVsNstrips_more15{},
-								 m_phiVsNstrips_100{},
-								 m_phiVsNstrips_111{},
-								 m_phiVsNstrips_Side{},
-								 m_phiVsNstrips_Side_100{},
-								 m_phiVsNstrips_Side_111{},
 								 m_holeSearchTool("InDet::InDetTrackHoleSearchTool"),
 								 m_pSCTHelper(nullptr),
-								 m_sctmgr(nullptr) {
+								 m_sctmgr(nullptr),
+								 m_waferGeometryValid(false),
+								 m_hitTree(nullptr) {
 								   /** sroe 3 Sept 2015:
 								       histoPathBase is declared as a property in the base class, assigned to m_path
 								       with default as empty string.
@@ -91,560 +109,193 @@ SCTLorentzMonTool::SCTLorentzMonTool(const string &type, const string &name,
 								   declareProperty("TrackToVertexTool", m_trackToVertexTool); // for TrackToVertexTool
 								   m_numberOfEvents = 0;
 								   declareProperty("HoleSearch", m_holeSearchTool);
+								   // non-empty: every hit is also written as a binary ArkaHitRecord to this file,
+								   // which MakeTree.C reads directly (no cout, no text parsing)
+								   declareProperty("HitRecordFile", m_hitRecordFile = "");
+								   // true: fill a per-hit TTree with the branches of MakeTree.C next to the profiles
+								   declareProperty("FillHitTree", m_fillHitTree = false);
+								   // true: that tree has the compact schema of MakeTree.C (floats, moduleKey, short, char)
+								   declareProperty("CompactHitTree", m_compactHitTree = false);
+								   // module categories on top of lowVdep, highVdep and wafer100, see SCTLorentzModuleTables.h:
+								   // a file and/or lines of "<category> <bec> <layer> <eta> <phi> <side>", * for any
+								   declareProperty("ModuleCategoryFile", m_moduleCategoryFile = "");
+								   declareProperty("ModuleCategories", m_moduleCategoryRules);
+								   // non-empty: only hits on modules of one of these categories pass the cuts
+								   declareProperty("SelectModuleCategories", m_selectModuleCategories);
+								   // AlignableTransformContainer whose updates move the wafers: the cached wafer axes are
+								   // rebuilt before the next event whenever it changes, empty for no callback
+								   declareProperty("AlignmentFolder", m_alignmentFolder = "/Indet/Align");
 								 }
 
 
-bool SCTLorentzMonTool::chooseModule(bool lowInVd0, const int eta, const int phi){
-  bool lowVd0 = false;
-  if(lowInVd0){
-    switch(eta){
-    case -6:
-      switch(phi){
-      case 7:
-	lowVd0 = true;
-	break;
-      case 14:
-	lowVd0 = true;
-	break;
-      case 18:
-	lowVd0 = true;
-	break;
-      case 23:
-	lowVd0 = true;
-	break;
-      case 26:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case -5:
-      switch(phi){
-      case 14:
-	lowVd0 = true;
-	break;
-      case 16:
-	lowVd0 = true;
-	break;
-      case 17:
-	lowVd0 = true;
-	break;
-      case 18:
-	lowVd0 = true;
-	break;
-      case 21:
-	lowVd0 = true;
-	break;
-      case 23:
-	lowVd0 = true;
-	break;
-      case 26:
-	lowVd0 = true;
-	break;
-      case 27:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case -4:
-      switch(phi){
-      case 20:
-	lowVd0 = true;
-	break;
-      case 23:
-	lowVd0 = true;
-	break;   
-      case 27:
-	lowVd0 = true;
-	break;  
-      case 29:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;   
-      }
-      break;        
-    case -3:
-      switch(phi){
-      case 20:
-	lowVd0 = true;
-	break;   
-      case 25:
-	lowVd0 = true;
-	break;   
-      case 27:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case -2:
-      switch(phi){
-      case 24:
-	lowVd0 = true;
-	break;   
-      case 31:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case -1:
-      switch(phi){
-      case 1:
-	lowVd0 = true;
-	break; 
-      case 6:
-	lowVd0 = true;
-	break;  
-      case 17:
-	lowVd0 = true;
-	break;   
-      case 24:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;   
-      case 27:
-	lowVd0 = true;
-	break;   
-      case 29:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 1:
-      switch(phi){
-      case 6:
-	lowVd0 = true;
-	break;   
-      case 12:
-	lowVd0 = true;
-	break;   
-      case 20:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;   
-      case 27:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 2:
-      switch(phi){
-      case 12:
-	lowVd0 = true;
-	break;   
-      case 16:
-	lowVd0 = true;
-	break;   
-      case 19:
-	lowVd0 = true;
-	break;   
-      case 22:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 3:
-      switch(phi){
-      case 3:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 4:
-      switch(phi){
-      case 5:
-	lowVd0 = true;
-	break;   
-      case 19:
-	lowVd0 = true;
-	break;   
-      case 20:
-	lowVd0 = true;
-	break; 
-      case 25:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;   
-      case 29:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 5:
-      switch(phi){
-      case 0:
-	lowVd0 = true;
-	break;  
-      case 1:
-	lowVd0 = true;
-	break;   
-      case 12:
-	lowVd0 = true;
-	break;   
-      case 19:
-	lowVd0 = true;
-	break;   
-      case 21:
-	lowVd0 = true;
-	break;   
-      case 26:
-	lowVd0 = true;
-	break;   
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    case 6:
-      switch(phi){
-      case 1:
-	lowVd0 = true;
-	break;   
-      case 18:
-	lowVd0 = true;
-	break;   
-      case 25:
-	lowVd0 = true;
-	break;   
-      case 31:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;        
-    default:
-      lowVd0 = false;
-      break;  
+// ====================================================================================================
+//                       SCTLorentzMonTool :: initialize
+// ====================================================================================================
+StatusCode
+SCTLorentzMonTool::initialize() {
+  ATH_CHECK(SCTMotherTrigMonTool::initialize());
+  if (m_alignmentFolder.empty()) return StatusCode::SUCCESS;
+  if (detStore()->contains<AlignableTransformContainer>(m_alignmentFolder)) {
+    ATH_CHECK(detStore()->regFcn(&SCTLorentzMonTool::alignmentCallback, this, m_alignmentHandle, m_alignmentFolder));
+    ATH_MSG_DEBUG("Registered alignment callback on " << m_alignmentFolder);
+  } else {
+    ATH_MSG_WARNING("No " << m_alignmentFolder << " in the detector store: the wafer axes are only rebuilt at booking");
+  }
+  return StatusCode::SUCCESS;
+}
+
+/// Called when the alignment changes, which can happen within a run: the wafer axes are rebuilt
+/// before the next event is filled, when the detector elements have picked up the new alignment.
+StatusCode
+SCTLorentzMonTool::alignmentCallback(IOVSVC_CALLBACK_ARGS) {
+  ATH_MSG_DEBUG("Alignment changed, the wafer axes are rebuilt for the next event");
+  m_waferGeometryValid = false;
+  return StatusCode::SUCCESS;
+}
+
+// ====================================================================================================
+//                       SCTLorentzMonTool :: buildWaferModules
+/// The decoded identifier of every wafer, by wafer hash: bec, layer, eta, phi, side, module key and
+/// the categories, one bit each, from the built-in lists and the ModuleCategoryFile /
+/// ModuleCategories properties. Built once, so that a hit needs one lookup instead of the SCT_ID
+/// decodes, and testing its module against any number of categories is a load and a mask.
+// ====================================================================================================
+StatusCode
+SCTLorentzMonTool::buildWaferModules() {
+  if (not m_waferModules.empty()) return StatusCode::SUCCESS;
+  SCTLorentz::ModuleCategories categories;
+  std::string error;
+  if (not m_moduleCategoryFile.empty() and not categories.Load(m_moduleCategoryFile, error)) {
+    ATH_MSG_ERROR("Module categories: " << error);
+    return StatusCode::FAILURE;
+  }
+  for (const std::string &rule : m_moduleCategoryRules) {
+    if (not categories.AddRule(rule, error)) {
+      ATH_MSG_ERROR("Module categories: " << error);
+      return StatusCode::FAILURE;
     }
   }
-    
-    
-  /// for high initial depletion voltage
-  else{
-    switch(eta){
-    case -6:
-      switch(phi){
-      case 2:
-	lowVd0 = true;
-	break;
-      case 6:
-	lowVd0 = true;
-	break;
-      case 15:
-	lowVd0 = true;
-	break;
-      case 17:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break; 
-      }
-      break;
-    case -5:
-      switch(phi){
-      case 0:
-	lowVd0 = true;
-	break;
-      case 2:
-	lowVd0 = true;
-	break;
-      case 3:
-	lowVd0 = true;
-	break;
-      case 9:
-	lowVd0 = true;
-	break;
-      case 12:
-	lowVd0 = true;
-	break;
-      case 15:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-                
-    case -4:
-      switch(phi){
-      case 6:
-	lowVd0 = true;
-	break;
-      case 8:
-	lowVd0 = true;
-	break;
-      case 12:
-	lowVd0 = true;
-	break;
-      case 13:
-	lowVd0 = true;
-	break;
-      case 21:
-	lowVd0 = true;
-	break;
-      case 22:
-	lowVd0 = true;
-	break;
-      case 24:
-	lowVd0 = true;
-	break;
-      case 25:
-	lowVd0 = true;
-	break;
-      case 30:
-	lowVd0 = true;
-	break;
-      case 31:
-	lowVd0 = true;
-	break; 
-      default:
-	lowVd0 = false;
-	break; 
-      }
-      break;
-    case -3:
-      switch(phi){
-      case 0:
-	lowVd0 = true;
-	break;
-      case 2:
-	lowVd0 = true;
-	break;
-      case 6:
-	lowVd0 = true;
-	break;
-      case 10:
-	lowVd0 = true;
-	break;
-      case 11:
-	lowVd0 = true;
-	break;
-      case 12:
-	lowVd0 = true;
-	break;
-      case 13:
-	lowVd0 = true;
-	break;
-      case 16:
-	lowVd0 = true;
-	break;
-      case 18:
-	lowVd0 = true;
-	break;
-      case 24:
-	lowVd0 = true;
-	break;
-      case 30:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-                
-    case -2:
-      switch(phi){
-      case 9:
-	lowVd0 = true;
-	break;
-      case 19:
-	lowVd0 = true;
-	break;
-      case 25:
-	lowVd0 = true;
-	break;
-      case 30:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-                
-    case -1:
-      switch(phi){
-      case 5:
-	lowVd0 = true;
-	break;
-      case 13:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      } 
-      break;
-    case 1: 
-      switch(phi){
-      case 3:
-	lowVd0 = true;
-	break;
-      case 10:
-	lowVd0 = true;
-	break;
-      case 13:
-	lowVd0 = true;
-	break;
-      case 25:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case 2:
-      switch(phi){
-      case 10:
-	lowVd0 = true;
-	break;
-      case 14:
-	lowVd0 = true;
-	break;
-      case 25:
-	lowVd0 = true;
-	break; 
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case 3:
-      switch(phi){
-      case 6:
-	lowVd0 = true;
-	break;
-      case 7:
-	lowVd0 = true;
-	break;
-      case 13:
-	lowVd0 = true;
-	break;
-      case 14:
-	lowVd0 = true;
-	break;
-      case 16:
-	lowVd0 = true;
-	break;
-      case 27:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case 4:
-      switch(phi){
-      case 1:
-	lowVd0 = true;
-	break;
-      case 2:
-	lowVd0 = true;
-	break;
-      case 8:
-	lowVd0 = true;
-	break;
-      case 17:
-	lowVd0 = true;
-	break;
-      case 18:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case 5:
-      switch(phi){
-      case 13:
-	lowVd0 = true;
-	break;
-      case 16:
-	lowVd0 = true;
-	break;
-      case 22:
-	lowVd0 = true;
-	break;
-      case 29:
-	lowVd0 = true;
-	break;
-      case 30:
-	lowVd0 = true;
-	break;
-      case 31:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
-      }
-      break;
-    case 6:
-      switch(phi){
-      case 6:
-	lowVd0 = true;
-	break;
-      case 14:
-	lowVd0 = true;
-	break;
-      default:
-	lowVd0 = false;
-	break;
+  m_selectedModulesMask = 0;
+  for (const std::string &name : m_selectModuleCategories) {
+    if (categories.Category(name) < 0) {
+      ATH_MSG_ERROR("Unknown module category " << name << " in SelectModuleCategories");
+      return StatusCode::FAILURE;
+    }
+    m_selectedModulesMask |= categories.Mask(name);
+  }
+  const unsigned int nWafers = m_pSCTHelper->wafer_hash_max();
+  m_waferModules.resize(nWafers);
+  for (unsigned int hash = 0; hash < nWafers; ++hash) {
+    const Identifier id = m_pSCTHelper->wafer_id(IdentifierHash(hash));
+    const int bec(m_pSCTHelper->barrel_ec(id));
+    const int layer(m_pSCTHelper->layer_disk(id));
+    const int side(m_pSCTHelper->side(id));
+    const int eta(m_pSCTHelper->eta_module(id));
+    const int phi(m_pSCTHelper->phi_module(id));
+    SCTLorentz::WaferModule &module = m_waferModules[hash];
+    module.bec = bec;
+    module.layer = layer;
+    module.eta = eta;
+    module.phi = phi;
+    module.side = side;
+    module.moduleKey = PackModuleKey(bec, layer, eta, phi, side);
+    module.flags = categories.Flags(bec, layer, eta, phi, side);
+  }
+  ATH_MSG_DEBUG(categories.Names().size() << " module categories over " << nWafers << " wafers");
+  return StatusCode::SUCCESS;
+}
+
+// ====================================================================================================
+//                       SCTLorentzMonTool :: buildWaferGeometry
+/// The normal, phi and eta axes of every wafer, by wafer hash (SCTLorentzGeometry.h), for the
+/// track angles. Rebuilt whenever the histograms are booked, i.e. at every new run and lumi block,
+/// and before the first event after an alignment update (alignmentCallback).
+// ====================================================================================================
+StatusCode
+SCTLorentzMonTool::buildWaferGeometry() {
+  const unsigned int nWafers = m_pSCTHelper->wafer_hash_max();
+  m_waferAxes.Resize(nWafers);
+  unsigned int nMissing = 0;
+  for (unsigned int hash = 0; hash < nWafers; ++hash) {
+    const InDetDD::SiDetectorElement *element = m_sctmgr->getDetectorElement(IdentifierHash(hash));
+    if (!element) {
+      ++nMissing;
+      continue;
+    }
+    const double normal[3] = {element->normal().x(), element->normal().y(), element->normal().z()};
+    const double phiAxis[3] = {element->phiAxis().x(), element->phiAxis().y(), element->phiAxis().z()};
+    const double etaAxis[3] = {element->etaAxis().x(), element->etaAxis().y(), element->etaAxis().z()};
+    m_waferAxes.Set(hash, normal, phiAxis, etaAxis);
+  }
+  if (nMissing == nWafers) {
+    ATH_MSG_ERROR("No SCT detector element found for any of the " << nWafers << " wafers");
+    return StatusCode::FAILURE;
+  }
+  m_waferGeometryValid = true;
+  ATH_MSG_DEBUG("wafer axes cached for " << nWafers - nMissing << " of " << nWafers << " wafers");
+  return StatusCode::SUCCESS;
+}
+
+// ====================================================================================================
+//                       SCTLorentzMonTool :: buildProfileFanOut
+/// For every wafer hash and path (measurement, hole), the profiles a hit on that wafer goes into,
+/// from the regions of SCTLorentzRegions.h, with the track |eta| slice each of them takes.
+/// Stored flat, m_profileFanOutBegin[path][hash] .. [hash + 1] indexing m_profileFanOut[path].
+// ====================================================================================================
+void
+SCTLorentzMonTool::buildProfileFanOut() {
+  const unsigned int nWafers = m_waferModules.size();
+  for (int path = 0; path != 2; ++path) {
+    const int pathBit = path == 0 ? SCTLorentz::kMeasurement : SCTLorentz::kHole;
+    m_profileFanOut[path].clear();
+    m_profileFanOutBegin[path].assign(1, 0);
+    for (unsigned int hash = 0; hash < nWafers; ++hash) {
+      const SCTLorentz::WaferModule &module = m_waferModules[hash];
+      for (unsigned int r = 0; r != SCTLorentz::kNProfileRegions; ++r) {
+        const SCTLorentz::ProfileRegion &region = SCTLorentz::kProfileRegions[r];
+        const int index = SCTLorentz::RegionModuleProfile(region, pathBit, module.bec, module.layer, module.eta,
+                                                          module.phi, module.side);
+        if (index >= 0) {
+          m_profileFanOut[path].push_back({m_regionProfiles[r][index], region.absEtaMin, region.absEtaMax});
+        }
       }
-      break;
-    default:
-      lowVd0 = false;
-      break;
+      m_profileFanOutBegin[path].push_back(m_profileFanOut[path].size());
+    }
+  }
+  ATH_MSG_DEBUG("profile fan-out: " << m_profileFanOut[0].size() << " measurement and " << m_profileFanOut[1].size()
+                << " hole entries over " << nWafers << " wafers");
+}
+
+/// The SCT wafer of a hole, from the detector element of its track parameters' surface, where the
+/// Identifier of the surface is decoded only if that is not a silicon element. False if the hole is
+/// not on the SCT.
+bool
+SCTLorentzMonTool::holeWaferHash(const Trk::TrackStateOnSurface *tsos, IdentifierHash &waferHash) const {
+  const Trk::TrackParameters *parameters = tsos->trackParameters();
+  const InDetDD::SiDetectorElement *element = parameters ?
+    dynamic_cast<const InDetDD::SiDetectorElement *>(parameters->associatedSurface().associatedDetectorElement()) : nullptr;
+  if (element) {
+    if (not element->isSCT()) return false;
+    waferHash = element->identifyHash();
+    return true;
+  }
+  const Identifier surfaceID = surfaceOnTrackIdentifier(tsos);
+  if (not m_pSCTHelper->is_sct(surfaceID)) return false;
+  waferHash = m_pSCTHelper->wafer_hash(m_pSCTHelper->wafer_id(surfaceID));
+  return true;
+}
+
+/// Fills the profiles of the wafer for a hit of the path (SCTLorentz::kMeasurement or kHole).
+void
+SCTLorentzMonTool::fillProfiles(int path, const IdentifierHash &waferHash, float phiToWafer, int nStrip, double trkEta) {
+  const int p = path == SCTLorentz::kMeasurement ? 0 : 1;
+  const double absEta = fabs(trkEta);
+  const ProfileFill *fills = m_profileFanOut[p].data();
+  for (uint32_t i = m_profileFanOutBegin[p][waferHash], end = m_profileFanOutBegin[p][waferHash + 1]; i != end; ++i) {
+    if (absEta > fills[i].absEtaMin and absEta <= fills[i].absEtaMax) {
+      fills[i].profile->Fill(phiToWafer, nStrip, 1.);
     }
   }
-  return lowVd0;
 }
 
 // ====================================================================================================
@@ -653,6 +304,21 @@ SCTLorentzMonTool::~SCTLorentzMonTool() {
   // nada
 }
 
+// ====================================================================================================
+//                       SCTLorentzMonTool :: finalize
+/// closes the hit record file here, where a failed write or close can still be reported
+// ====================================================================================================
+StatusCode
+SCTLorentzMonTool::finalize() {
+  if (m_hitRecords) {
+    if (not m_hitRecords->Close()) {
+      ATH_MSG_ERROR("Error writing hit record file " << m_hitRecordFile << ", it is incomplete");
+    }
+    m_hitRecords.reset();
+  }
+  return SCTMotherTrigMonTool::finalize();
+}
+
 // ====================================================================================================
 //                       SCTLorentzMonTool :: bookHistograms
 // ====================================================================================================
@@ -675,6 +341,15 @@ SCTLorentzMonTool::bookHistogramsRecurrent( ) {
   ATH_MSG_DEBUG("SCT detector manager found: layout is \"" << m_sctmgr->getLayout() << "\"");
   /* Retrieve TrackToVertex extrapolator tool */
   ATH_CHECK(m_trackToVertexTool.retrieve());
+  ATH_CHECK(buildWaferModules());
+  ATH_CHECK(buildWaferGeometry());
+  if (not m_hitRecordFile.empty() and not m_hitRecords) {
+    m_hitRecords.reset(new ArkaRecordWriter(m_hitRecordFile.c_str()));
+    if (not m_hitRecords->IsOpen()) {
+      ATH_MSG_ERROR("Cannot open hit record file " << m_hitRecordFile);
+      return StatusCode::FAILURE;
+    }
+  }
   // Booking  Track related Histograms
   if (bookLorentzHistos().isFailure()) {
     msg(MSG::WARNING) << "Error in bookLorentzHistos()" << endmsg;                                // hidetoshi 14.01.22
@@ -700,6 +375,15 @@ SCTLorentzMonTool::bookHistograms( ) {
   ATH_MSG_DEBUG("SCT detector manager found: layout is \"" << m_sctmgr->getLayout() << "\"");
   /* Retrieve TrackToVertex extrapolator tool */
   ATH_CHECK(m_trackToVertexTool.retrieve());
+  ATH_CHECK(buildWaferModules());
+  ATH_CHECK(buildWaferGeometry());
+  if (not m_hitRecordFile.empty() and not m_hitRecords) {
+    m_hitRecords.reset(new ArkaRecordWriter(m_hitRecordFile.c_str()));
+    if (not m_hitRecords->IsOpen()) {
+      ATH_MSG_ERROR("Cannot open hit record file " << m_hitRecordFile);
+      return StatusCode::FAILURE;
+    }
+  }
   // Booking  Track related Histograms
   if (bookLorentzHistos().isFailure()) {
     msg(MSG::WARNING) << "Error in bookLorentzHistos()" << endmsg;                                // hidetoshi 14.01.22
@@ -713,31 +397,10 @@ SCTLorentzMonTool::bookHistograms( ) {
 // ====================================================================================================
 StatusCode
 SCTLorentzMonTool::fillHistograms() {
-  // should use database for this!
-  constexpr int layer100[] = {
-    2, 2, 3, 2, 2, 2, 0, 2, 3, 2, 0, 2, 3, 2, 3, 2, 0, 2, 3, 0, 2, 0, 2, 3, 2, 2, 2, 0, 0, 0, 0, 0, 0, 3, 0, 3, 2, 0, 2,
-    2, 0, 3, 3, 3, 0, 2, 2, 2, 2, 2, 2, 2, 3, 2, 2, 3, 3, 2, 2, 2, 2, 2, 3, 3, 2, 3, 2, 2, 2, 3, 3, 3, 2, 2, 2, 2, 3, 3,
-    2, 3, 2, 3, 3, 2, 3, 2, 2, 2, 2, 2, 2, 2
-  };
-  constexpr int phi100[] = {
-    29, 29, 6, 13, 23, 13, 14, 29, 9, 29, 14, 29, 9, 29, 39, 32, 21, 32, 13, 22, 32, 22, 32, 13, 32, 32, 32, 20, 20, 20,
-    20, 20, 20, 13, 21, 17, 33, 5, 33, 33, 31, 6, 19, 47, 21, 37, 37, 37, 37, 33, 37, 37, 24, 33, 33, 47, 19, 33, 33,
-    37, 37, 37, 55, 9, 38, 24, 37, 38, 8, 9, 9, 26, 38, 38, 38, 38, 39, 39, 38, 11, 45, 54, 54, 24, 31, 14, 47, 45, 47,
-    47, 47, 47
-  };
-  constexpr int eta100[] = {
-    3, -4, -6, 2, 6, 3, -5, -1, 6, -2, -6, -5, 5, -3, 2, 6, -3, 5, 5, 3, 4, 2, 2, 2, -1, -3, -4, 1, -1, -2, -3, -4, 4,
-    -1, -5, 6, 2, 4, 3, 1, 6, -2, 6, 3, -6, -1, 2, 1, 3, -5, 4, 5, -3, -4, -3, -5, -2, -1, -2, -3, -2, -4, -3, 2, 3, -6,
-    -5, 4, 6, 1, -6, 1, 1, -5, -4, -3, -3, -5, -2, 1, 5, 5, 4, 4, 5, 4, -1, -5, 3, 4, 1, -5
-  };
-  constexpr unsigned int layer100_n = sizeof(layer100) / sizeof(*layer100);
-  constexpr unsigned int phi100_n = sizeof(phi100) / sizeof(*phi100);
-  constexpr unsigned int eta100_n = sizeof(eta100) / sizeof(*eta100);
-  constexpr bool theseArraysAreEqualInLength = ((layer100_n == phi100_n)and(phi100_n == eta100_n));
-
-  static_assert(theseArraysAreEqualInLength, "Coordinate arrays for <100> wafers are not of equal length");
-
   ATH_MSG_DEBUG("enters fillHistograms");
+  if (not m_waferGeometryValid) {
+    ATH_CHECK(buildWaferGeometry());
+  }
   
   const TrackCollection *tracks(0);
   if (evtStore()->contains<TrackCollection> (m_tracksName)) {
@@ -816,6 +479,10 @@ SCTLorentzMonTool::fillHistograms() {
     float phiToWaferL3S0(-999.);
     float phiToWaferL3S1(-999.);
     bool makePrintout=false;
+    // first the SCT measurements and holes of the track, in track order, with their wafer and
+    // momentum, so that the angles to the wafers are found for all of them in one call
+    TrackHits &hits = m_trackHits;
+    hits.clear();
     DataVector<const Trk::TrackStateOnSurface>::const_iterator endit = trackStates->end();
     for (DataVector<const Trk::TrackStateOnSurface>::const_iterator it = trackStates->begin(); it != endit; ++it) {
       if ((*it)->type(Trk::TrackStateOnSurface::Measurement)) {
@@ -827,25 +494,7 @@ SCTLorentzMonTool::fillHistograms() {
             continue; // Continue if dynamic_cast returns null
           }
           if (RawDataClus->detectorElement()->isSCT()) {
-            const Identifier sct_id = clus->identify();
-            const int bec(m_pSCTHelper->barrel_ec(sct_id));
-            const int layer(m_pSCTHelper->layer_disk(sct_id));
-            const int side(m_pSCTHelper->side(sct_id));
-            const int eta(m_pSCTHelper->eta_module(sct_id));
-            const int phi(m_pSCTHelper->phi_module(sct_id));
-
-            bool in100 = false;
-	    //             if (bec != 0) {//take EC
-	    //               continue; // We only care about the barrel
-	    //             }
-            // wtf is this?
-            for (unsigned int i = 0; i < layer100_n; i++) {
-              if (layer100[i] == layer && eta100[i] == eta && phi100[i] == phi) {
-                in100 = true;
-                break;
-              }
-            }
-            
+            const IdentifierHash waferHash(RawDataClus->detectorElement()->identifyHash());
             // find cluster size
             const std::vector<Identifier> &rdoList = RawDataClus->rdoList();
             int nStrip = rdoList.size();
@@ -854,430 +503,118 @@ SCTLorentzMonTool::fillHistograms() {
               msg(MSG::WARNING) << " Null pointer to MeasuredTrackParameters" << endmsg;
               continue;
             }
-            const Trk::Perigee *perigee = track->perigeeParameters();
-
-            if (perigee) {
-              // Get angle to wafer surface
-              float phiToWafer(90.), thetaToWafer(90.);
-              float sinAlpha = 0.; // for barrel, which is the only thing considered here
-              float pTrack[3];
-              pTrack[0] = trkp->momentum().x();
-              pTrack[1] = trkp->momentum().y();
-              pTrack[2] = trkp->momentum().z();
-              int iflag = findAnglesToWaferSurface(pTrack, sinAlpha, clus->identify(), thetaToWafer, phiToWafer);
-              if (iflag < 0) {
-                msg(MSG::WARNING) << "Error in finding track angles to wafer surface" << endmsg;
-                continue; // Let's think about this (later)... continue, break or return?
-              }
-              bool passesCuts = true;
-
-              if ((AthenaMonManager::dataType() == AthenaMonManager::cosmics) &&
-                  (trkp->momentum().mag() > 500.) &&  // Pt > 500MeV
-                  (summary->get(Trk::numberOfSCTHits) > 7)// && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
-                  ) {
-                passesCuts = true;
-              }// 01.02.2015
-              else if( (track->perigeeParameters()->parameters()[Trk::qOverP] < 0.) && // use negative track only for 2015 selection, now with Taka's request this is removed on Jan 29, 2018
-		       (fabs( perigee->parameters()[Trk::d0] ) < 1.) &&  // d0 < 1mm
-                       //(fabs( perigee->parameters()[Trk::z0] * sin(perigee->parameters()[Trk::theta]) ) < 1.) && // d0 < 1mm 
-                       (trkp->momentum().perp() > 500.) &&   // Pt > 500MeV 
-		       (summary->get(Trk::numberOfSCTHits) > 7 ) && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
-		       (summary->get(Trk::numberOfPixelHits) > 1) // number of pixel hits > 1, added by Arka on August 9, 2017
-                       ){
-                passesCuts=true;
-              }else {
-                passesCuts = false;
-              }
-
-              if (passesCuts) {
-                // Fill profile
-		//                 if(bec != 0)continue;//take EC
-                //if(layer!=0)continue;
-                bool lowInVd0Here = false;
-                bool lowVd0Here = chooseModule(lowInVd0Here, eta, phi);
-                /// selecting only the low vdep sensors
-                
-                //if(!lowVd0Here)continue; // select only few modules
-                
-                if(bec==0){
-                    m_phiVsNstrips[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                
-                if(bec==0 && fabs(trkp->eta()) <= 0.75){
-                    m_phiVsNstrips_075[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if(bec==0 && fabs(trkp->eta()) > 0.75 && fabs(trkp->eta()) <= 1.5){
-                    m_phiVsNstrips_15[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if(bec==0 && fabs(trkp->eta()) > 1.5){
-                    m_phiVsNstrips_more15[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                ///end cap region, EC region C Q1
-                if((bec==-2) && (phi>=0 && phi<=12) && (eta>=0 && eta<=2)){
-                    m_phiVsNstripsEC[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=0 && phi<=9) && eta==2){
-                    m_phiVsNstripsEC_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=0 && phi<=9) && eta==1 ){
-                    m_phiVsNstripsEC_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=0 && phi<=12) && eta==0 ){
-                    m_phiVsNstripsEC_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                ///end cap region, EC Region A Q2
-                if((bec==2) && (phi>=10 && phi<=26) && (eta>=0 && eta<=2)){
-                    m_phiVsNstripsEC2[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=11 && phi<=20) && eta==2){
-                    m_phiVsNstripsEC2_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=10 && phi<=19) && eta==1 ){
-                    m_phiVsNstripsEC2_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=14 && phi<=26) && eta==0 ){
-                    m_phiVsNstripsEC2_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                
-                
-                ///end cap region different sides
-                if((bec==-2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 0){
-                    m_phiVsNstripsECSide0[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=20 && phi<=29) && eta==2 && side == 0){
-                    m_phiVsNstripsECSide0_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=20 && phi<=29) && eta==1 && side == 0){
-                    m_phiVsNstripsECSide0_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=26 && phi<=38) && eta==0 && side == 0){
-                    m_phiVsNstripsECSide0_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                ///end cap region
-                if((bec==2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 0){
-                    m_phiVsNstripsECSide02[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=20 && phi<=29) && eta==2 && side == 0){
-                    m_phiVsNstripsECSide02_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=20 && phi<=29) && eta==1 && side == 0){
-                    m_phiVsNstripsECSide02_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=26 && phi<=38) && eta==0 && side == 0){
-                    m_phiVsNstripsECSide02_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                ///end cap region
-                if((bec==-2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 1){
-                    m_phiVsNstripsECSide1[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=20 && phi<=29) && eta==2 && side == 1){
-                    m_phiVsNstripsECSide1_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=20 && phi<=29) && eta==1 && side == 1){
-                    m_phiVsNstripsECSide1_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==-2) && (phi>=26 && phi<=38) && eta==0 && side == 1){
-                    m_phiVsNstripsECSide1_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                ///end cap region
-                if((bec==2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 1){
-                    m_phiVsNstripsECSide12[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=20 && phi<=29) && eta==2 && side == 1){
-                    m_phiVsNstripsECSide12_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=20 && phi<=29) && eta==1 && side == 1){
-                    m_phiVsNstripsECSide12_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                if((bec==2) && (phi>=26 && phi<=38) && eta==0 && side == 1){
-                    m_phiVsNstripsECSide12_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-                }
-                
-                
-                uint64_t event_number = eventID->event_number();
-                const Trk::Perigee* startPerigee = track2->perigeeParameters();
-                //float phi0 = 
-                float trackPhi = startPerigee->parameters()[Trk::phi0]; //atan2(trkp->position().y(), trkp->position().x());
-                if(makePrintout)std::cout << "Arka " << event_number << " " << trkp->momentum().perp() << " " << trkp->eta() << " " << trackPhi << " " << phiToWafer << " " << nStrip << " " << bec << " " << layer << " " << eta << " " << phi << " " << side << " " << trkp->charge() << std::endl;
-                
-                if(bec==0)m_phiVsNstrips_Side[layer][side]->Fill(phiToWafer, nStrip, 1.);
-                
-                if (layer==0 and side==0) {
-                    etaL0S0 = eta;
-                    phiL0S0 = phi;
-                    phiToWaferL0S0 = phiToWafer;
-                } else if (layer==0 and side==1) {
-                    etaL0S1 = eta;
-                    phiL0S1 = phi;
-                    phiToWaferL0S1 = phiToWafer;
-                } else if (layer==1 and side==0) {
-                    etaL1S0 = eta;
-                    phiL1S0 = phi;
-                    phiToWaferL1S0 = phiToWafer;
-                } else if (layer==1 and side==1) {
-                    etaL1S1 = eta;
-                    phiL1S1 = phi;
-                    phiToWaferL1S1 = phiToWafer;
-                } else if (layer==2 and side==0) {
-                    etaL2S0 = eta;
-                    phiL2S0 = phi;
-                    phiToWaferL2S0 = phiToWafer;
-                } else if (layer==2 and side==1) {
-                    etaL2S1 = eta;
-                    phiL2S1 = phi;
-                    phiToWaferL2S1 = phiToWafer;
-                } else if (layer==3 and side==0) {
-                    etaL3S0 = eta;
-                    phiL3S0 = phi;
-                    phiToWaferL3S0 = phiToWafer;
-                } else if (layer==3 and side==1) {
-                    etaL3S1 = eta;
-                    phiL3S1 = phi;
-                    phiToWaferL3S1 = phiToWafer;
-                }
-                
-
-                if (in100) {
-                  // cout << "This event is going to 100" << endl;
-                  if(bec==0)m_phiVsNstrips_100[layer]->Fill(phiToWafer, nStrip, 1.);
-                  if(bec==0)m_phiVsNstrips_Side_100[layer][side]->Fill(phiToWafer, nStrip, 1.);
-                  
-                }else {
-                  if(bec==0)m_phiVsNstrips_111[layer]->Fill(phiToWafer, nStrip, 1.);
-                  if(bec==0)m_phiVsNstrips_Side_111[layer][side]->Fill(phiToWafer, nStrip, 1.);
-                }
-              }// end if passesCuts
-            }// end if mtrkp
+            hits.add(SCTLorentz::kMeasurement, trkp, waferHash, nStrip,
+                     trkp->momentum().x(), trkp->momentum().y(), trkp->momentum().z());
           } // end if SCT..
         } // end if(clus)
       } // if((*it)->type(Trk::TrackStateOnSurface::Measurement)){
       else if((*it)->type(Trk::TrackStateOnSurface::Hole)) {
-	Identifier surfaceID;
-	surfaceID = surfaceOnTrackIdentifier(*it);
-	if(not m_pSCTHelper->is_sct(surfaceID)) continue; //We only care about SCT
-	const int bec(m_pSCTHelper->barrel_ec(surfaceID));
-	const int layer(m_pSCTHelper->layer_disk(surfaceID));
-	const int side(m_pSCTHelper->side(surfaceID));
-	const int eta(m_pSCTHelper->eta_module(surfaceID));
-	const int phi(m_pSCTHelper->phi_module(surfaceID));
-	bool in100 = false;
-	// 	if(bec!=0) {
-	// 	  continue; //We only care about the barrel
-	// 	}
-	//wtf is this?
-	for (unsigned int i=0 ; i<layer100_n ; i++){
-	  if (layer100[i]==layer && eta100[i]==eta && phi100[i]==phi){
-	    in100=true;
-	    break;
-	  }
-	}
-	// find cluster size
-	int nStrip = 0;
+	IdentifierHash waferHash;
+	if (not holeWaferHash(*it, waferHash)) continue; //We only care about SCT
 	const Trk::TrackParameters *trkp = dynamic_cast<const Trk::TrackParameters*>( (*it)->trackParameters() );
 	if (not trkp) {
 	  ATH_MSG_WARNING(" Null pointer to MeasuredTrackParameters");
 	  continue;
 	}
+	hits.add(SCTLorentz::kHole, trkp, waferHash, 0, trkp->momentum().x(), trkp->momentum().y(), trkp->momentum().z());
+      }
+    }// end of loop on TrackStatesonSurface (they can be SiClusters, TRTHits,..)
 
-	const Trk::Perigee* perigee = track->perigeeParameters();
-
-	if (perigee){
-	  //Get angle to wafer surface
-	  float phiToWafer(90.),thetaToWafer(90.);
-	  float sinAlpha = 0.; //for barrel, which is the only thing considered here
-	  float pTrack[3];
-	  pTrack[0] = trkp->momentum().x();
-	  pTrack[1] = trkp->momentum().y();
-	  pTrack[2] = trkp->momentum().z();
-	  int iflag = findAnglesToWaferSurface (pTrack, sinAlpha, surfaceID, thetaToWafer, phiToWafer );
-	  if ( iflag < 0) {
-	    ATH_MSG_WARNING("Error in finding track angles to wafer surface");
-	    continue; // Let's think about this (later)... continue, break or return?
-	  }
-	  bool passesCuts = true;
-	  if( (AthenaMonManager::dataType() ==  AthenaMonManager::cosmics) &&
-	      (trkp->momentum().mag() > 500.) &&  // Pt > 500MeV
-	      (summary->get(Trk::numberOfSCTHits) > 7 )// && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
-	      ){
-	    passesCuts=true;
-	  }
-	  else if( (track->perigeeParameters()->parameters()[Trk::qOverP] < 0.) && // use negative track only for 2015 selection, now with Taka's request this is removed on Jan 29, 2018
-		   (fabs( perigee->parameters()[Trk::d0] ) < 1.) &&  // d0 < 1mm
-		   //(fabs( perigee->parameters()[Trk::z0] * sin(perigee->parameters()[Trk::theta]) ) < 1.) && // d0 < 1mm 
-		   (trkp->momentum().perp() > 500.) &&   // Pt > 500MeV 
-		   (summary->get(Trk::numberOfSCTHits) > 7 ) && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
-		   (summary->get(Trk::numberOfPixelHits) > 1) // number of pixel hits > 1, added by Arka on August 9, 2017
-		   ){
-	    passesCuts=true;
-	  }else{
-	    passesCuts=false;
-	  }
+    const Trk::Perigee *perigee = track->perigeeParameters();
+    if (perigee) {
+      // Get angles to wafer surface
+      findAnglesToWaferSurface(hits.size(), hits.waferHash.data(), hits.px.data(), hits.py.data(), hits.pz.data(),
+                               hits.theta.data(), hits.phi.data(), hits.ok.data());
+    }
+    for (unsigned int i = 0; perigee and i != hits.size(); ++i) {
+      if (not hits.ok[i]) {
+        msg(MSG::WARNING) << "Error in finding track angles to wafer surface" << endmsg;
+        continue; // Let's think about this (later)... continue, break or return?
+      }
+      const Trk::TrackParameters *trkp = hits.parameters[i];
+      const IdentifierHash waferHash(hits.waferHash[i]);
+      const float phiToWafer = hits.phi[i];
+      const int nStrip = hits.nStrip[i];
+      bool passesCuts = true;
+
+      if ((AthenaMonManager::dataType() == AthenaMonManager::cosmics) &&
+          (trkp->momentum().mag() > 500.) &&  // Pt > 500MeV
+          (summary->get(Trk::numberOfSCTHits) > 7)// && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
+          ) {
+        passesCuts = true;
+      }// 01.02.2015
+      else if( (track->perigeeParameters()->parameters()[Trk::qOverP] < 0.) && // use negative track only for 2015 selection, now with Taka's request this is removed on Jan 29, 2018
+               (fabs( perigee->parameters()[Trk::d0] ) < 1.) &&  // d0 < 1mm
+               //(fabs( perigee->parameters()[Trk::z0] * sin(perigee->parameters()[Trk::theta]) ) < 1.) && // d0 < 1mm 
+               (trkp->momentum().perp() > 500.) &&   // Pt > 500MeV 
+               (summary->get(Trk::numberOfSCTHits) > 7 ) && // #SCTHits >6, /// changed to 7 from 6 by Arka on August 9, 2017
+               (summary->get(Trk::numberOfPixelHits) > 1) // number of pixel hits > 1, added by Arka on August 9, 2017
+               ){
+        passesCuts=true;
+      }else {
+        passesCuts = false;
+      }
+      if (m_selectedModulesMask and not (m_waferModules[waferHash].flags & m_selectedModulesMask)) {
+        passesCuts = false;
+      }
 
-	  if (passesCuts) {
-	    // Fill profile
-            //if(bec != 0)continue;//take EC
-            //if(layer!=0)continue;
-            bool lowInVd0Here = false;
-            bool lowVd0Here = chooseModule(lowInVd0Here, eta, phi);
-                
-            /// selecting only the low vdep sensors
-            //if(!lowVd0Here)continue; // select only few modules
-            
-	    if(bec==0)m_phiVsNstrips[layer]->Fill(phiToWafer, nStrip, 1.);
-            if (layer==0 and side==0) {
-                etaL0S0 = eta;
-                phiL0S0 = phi;
-                phiToWaferL0S0 = phiToWafer;
-            } else if (layer==0 and side==1) {
-                etaL0S1 = eta;
-                phiL0S1 = phi;
-                phiToWaferL0S1 = phiToWafer;
-            } else if (layer==1 and side==0) {
-                etaL1S0 = eta;
-                phiL1S0 = phi;
-                phiToWaferL1S0 = phiToWafer;
-            } else if (layer==1 and side==1) {
-                etaL1S1 = eta;
-                phiL1S1 = phi;
-                phiToWaferL1S1 = phiToWafer;
-            } else if (layer==2 and side==0) {
-                etaL2S0 = eta;
-                phiL2S0 = phi;
-                phiToWaferL2S0 = phiToWafer;
-            } else if (layer==2 and side==1) {
-                etaL2S1 = eta;
-                phiL2S1 = phi;
-                phiToWaferL2S1 = phiToWafer;
-            } else if (layer==3 and side==0) {
-                etaL3S0 = eta;
-                phiL3S0 = phi;
-                phiToWaferL3S0 = phiToWafer;
-            } else if (layer==3 and side==1) {
-                etaL3S1 = eta;
-                phiL3S1 = phi;
-                phiToWaferL3S1 = phiToWafer;
-            }
-                
-            if(bec==0 && fabs(trkp->eta()) <= 0.75) m_phiVsNstrips_075[layer]->Fill(phiToWafer, nStrip, 1.);
-            if(bec==0 && fabs(trkp->eta()) > 0.75 && fabs(trkp->eta()) <= 1.5) m_phiVsNstrips_15[layer]->Fill(phiToWafer, nStrip, 1.);
-            if(bec==0 && fabs(trkp->eta()) > 1.5)m_phiVsNstrips_more15[layer]->Fill(phiToWafer, nStrip, 1.);
-            
-            ///end cap region
-            if((bec==-2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2)){
-                m_phiVsNstripsEC[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=20 && phi<=29) && eta==2){
-                m_phiVsNstripsEC_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=20 && phi<=29) && eta==1 ){
-                m_phiVsNstripsEC_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=26 && phi<=38) && eta==0 ){
-                m_phiVsNstripsEC_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            
-            ///end cap region, EC region C Q1
-            if((bec==-2) && (phi>=0 && phi<=12) && (eta>=0 && eta<=2)){
-                m_phiVsNstripsEC[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=0 && phi<=9) && eta==2){
-                m_phiVsNstripsEC_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=0 && phi<=9) && eta==1 ){
-                m_phiVsNstripsEC_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=0 && phi<=12) && eta==0 ){
-                m_phiVsNstripsEC_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            
-            ///end cap region, EC Region A Q2
-            if((bec==2) && (phi>=10 && phi<=26) && (eta>=0 && eta<=2)){
-                m_phiVsNstripsEC2[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=11 && phi<=20) && eta==2){
-                m_phiVsNstripsEC2_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=10 && phi<=19) && eta==1 ){
-                m_phiVsNstripsEC2_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=14 && phi<=26) && eta==0 ){
-                m_phiVsNstripsEC2_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            ///end cap region, different side
-            if((bec==2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 0){
-                m_phiVsNstripsECSide02[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=20 && phi<=29) && eta==2 && side == 0){
-                m_phiVsNstripsECSide02_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=20 && phi<=29) && eta==1 && side == 0){
-                m_phiVsNstripsECSide02_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=26 && phi<=38) && eta==0 && side == 0){
-                m_phiVsNstripsECSide02_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            
-            ///end cap region
-            if((bec==-2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 1){
-                m_phiVsNstripsECSide1[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=20 && phi<=29) && eta==2 && side == 1){
-                m_phiVsNstripsECSide1_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=20 && phi<=29) && eta==1 && side == 1){
-                m_phiVsNstripsECSide1_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==-2) && (phi>=26 && phi<=38) && eta==0 && side == 1){
-                m_phiVsNstripsECSide1_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            
-            ///end cap region
-            if((bec==2) && (phi>=20 && phi<=38) && (eta>=0 && eta<=2) && side == 1){
-                m_phiVsNstripsECSide12[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=20 && phi<=29) && eta==2 && side == 1){
-                m_phiVsNstripsECSide12_Inner[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=20 && phi<=29) && eta==1 && side == 1){
-                m_phiVsNstripsECSide12_Middle[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            if((bec==2) && (phi>=26 && phi<=38) && eta==0 && side == 1){
-                m_phiVsNstripsECSide12_Outer[layer]->Fill(phiToWafer, nStrip, 1.);
-            }
-            
-            
-                
-            uint64_t event_number = eventID->event_number();
-            
-            const Trk::Perigee* startPerigee = track2->perigeeParameters();
-            float trackPhi = startPerigee->parameters()[Trk::phi0]; //atan2(trkp->position().y(), trkp->position().x());
-                
-            if(makePrintout)std::cout << "Arka " << event_number << " " << trkp->momentum().perp() << " " << trkp->eta() << " " << trackPhi << " " << phiToWafer << " " << nStrip << " " << bec << " " << layer << " " << eta << " " << phi << " " << side << " " << trkp->charge() << std::endl;
-            
-            if(bec==0)m_phiVsNstrips_Side[layer][side]->Fill(phiToWafer, nStrip, 1.);
-            if (in100) {
-            // cout << "This event is going to 100" << endl;
-            if(bec==0)m_phiVsNstrips_100[layer]->Fill(phiToWafer, nStrip, 1.);
-            if(bec==0)m_phiVsNstrips_Side_100[layer][side]->Fill(phiToWafer, nStrip, 1.);
-            }else {
-            if(bec==0)m_phiVsNstrips_111[layer]->Fill(phiToWafer, nStrip, 1.);
-            if(bec==0)m_phiVsNstrips_Side_111[layer][side]->Fill(phiToWafer, nStrip, 1.);
-            }
-        }// end if passesCuts
-      }// end if mtrkp
-	//            delete perigee;perigee = 0;
-	//  } // end if SCT..
-	//} // end if(clus)
-      } // if((*it)->type(Trk::TrackStateOnSurface::Measurement)){
-      
-    }// end of loop on TrackStatesonSurface (they can be SiClusters, TRTHits,..)
+      if (passesCuts) {
+        const SCTLorentz::WaferModule &module = m_waferModules[waferHash];
+        const int bec(module.bec);
+        const int layer(module.layer);
+        const int side(module.side);
+        const int eta(module.eta);
+        const int phi(module.phi);
+        // Fill profile
+        //if(bec != 0)continue;//take EC
+        //if(layer!=0)continue;
+        /// selecting only the low vdep sensors: SelectModuleCategories = ["lowVdep"]
+        
+        fillProfiles(hits.path[i], waferHash, phiToWafer, nStrip, trkp->eta());
+        
+        uint64_t event_number = eventID->event_number();
+        const Trk::Perigee* startPerigee = track2->perigeeParameters();
+        //float phi0 = 
+        float trackPhi = startPerigee->parameters()[Trk::phi0]; //atan2(trkp->position().y(), trkp->position().x());
+        if(makePrintout)std::cout << "Arka " << event_number << " " << trkp->momentum().perp() << " " << trkp->eta() << " " << trackPhi << " " << phiToWafer << " " << nStrip << " " << bec << " " << layer << " " << eta << " " << phi << " " << side << " " << trkp->charge() << '\n';
+        if(m_hitRecords)m_hitRecords->Write(makeHitRecord(event_number, trkp->momentum().perp(), trkp->eta(), trackPhi, phiToWafer, nStrip, module, trkp->charge()));
+        if(m_hitTree)fillHitTree(event_number, trkp->momentum().perp(), trkp->eta(), trackPhi, phiToWafer, nStrip, module, trkp->charge());
+        
+        if (layer==0 and side==0) {
+            etaL0S0 = eta;
+            phiL0S0 = phi;
+            phiToWaferL0S0 = phiToWafer;
+        } else if (layer==0 and side==1) {
+            etaL0S1 = eta;
+            phiL0S1 = phi;
+            phiToWaferL0S1 = phiToWafer;
+        } else if (layer==1 and side==0) {
+            etaL1S0 = eta;
+            phiL1S0 = phi;
+            phiToWaferL1S0 = phiToWafer;
+        } else if (layer==1 and side==1) {
+            etaL1S1 = eta;
+            phiL1S1 = phi;
+            phiToWaferL1S1 = phiToWafer;
+        } else if (layer==2 and side==0) {
+            etaL2S0 = eta;
+            phiL2S0 = phi;
+            phiToWaferL2S0 = phiToWafer;
+        } else if (layer==2 and side==1) {
+            etaL2S1 = eta;
+            phiL2S1 = phi;
+            phiToWaferL2S1 = phiToWafer;
+        } else if (layer==3 and side==0) {
+            etaL3S0 = eta;
+            phiL3S0 = phi;
+            phiToWaferL3S0 = phiToWafer;
+        } else if (layer==3 and side==1) {
+            etaL3S1 = eta;
+            phiL3S1 = phi;
+            phiToWaferL3S1 = phiToWafer;
+        }
+      }// end if passesCuts
+    }// end of loop on the SCT hits of the track
     if (etaL0S0!=-999 and etaL0S0==etaL0S1 /*and phiL0S0!=-999*/ and phiL0S0==phiL0S1) {
       side0VsSide1_IncidenceAngle[0]->Fill(phiToWaferL0S0, phiToWaferL0S1);
     }
@@ -1314,6 +651,10 @@ SCTLorentzMonTool::procHistograms() {
     if (checkHists(true).isFailure()) {
       ATH_MSG_WARNING("Error in checkHists(true)");
     }
+    if (m_hitRecords) {
+      if (not m_hitRecords->Flush()) ATH_MSG_ERROR("Error writing hit record file " << m_hitRecordFile << ", it is incomplete");
+      ATH_MSG_DEBUG(m_hitRecords->GetCount() << " hit records written to " << m_hitRecordFile);
+    }
   }
   ATH_MSG_DEBUG("Exiting finalHists");
   return StatusCode::SUCCESS;
@@ -1332,7 +673,6 @@ SCTLorentzMonTool::bookLorentzHistos() {
                                                                                                                                                         // hidetoshi
                                                                                                                                                         // 14.01.22
   const int nLayers(4);
-  const int nECLayers(9);
   const int nSides(2);
   string stem = m_path + "/SCT/GENERAL/lorentz/";
   //    MonGroup Lorentz(this,m_path+"SCT/GENERAL/lorentz",expert,run);        // hidetoshi 14.01.21
@@ -1341,247 +681,50 @@ SCTLorentzMonTool::bookLorentzHistos() {
   string hNum[nLayers] = {
     "0", "1", "2", "3"
   };
-  string hNumEC[nECLayers] = {
-    "0", "1", "2", "3", "4", "5", "6", "7", "8"
-  };
-  string hNumS[nSides] = {
-    "0", "1"
-  };
   int nProfileBins = 360;
 
   int success = 1;
 
-  for (int l = 0; l != nLayers; ++l) {
-    // granularity set to one profile/layer for now
-    int iflag = 0;
-    m_phiVsNstrips_100[l] = pFactory("h_phiVsNstrips_100" + hNum[l], "100 - Inc. Angle vs nStrips for Layer " + hNum[l],
-                                     nProfileBins, -90., 90., Lorentz, iflag);
-    m_phiVsNstrips_111[l] = pFactory("h_phiVsNstrips_111" + hNum[l], "111 - Inc. Angle vs nStrips for Layer " + hNum[l],
+  // the angle vs nStrip profiles, one row of SCTLorentzRegions.h each; rows naming a profile
+  // that is already booked share its pointers
+  m_regionProfiles.assign(SCTLorentz::kNProfileRegions, std::vector<TProfile *>());
+  std::map<std::string, unsigned int> booked;
+  for (unsigned int r = 0; r != SCTLorentz::kNProfileRegions; ++r) {
+    const SCTLorentz::ProfileRegion &region = SCTLorentz::kProfileRegions[r];
+    const auto it = booked.find(region.name);
+    if (it != booked.end()) {
+      m_regionProfiles[r] = m_regionProfiles[it->second];
+      continue;
+    }
+    booked[region.name] = r;
+    for (int l = 0; l != SCTLorentz::RegionLayers(region); ++l) {
+      for (int side = 0; side != (region.perSide ? nSides : 1); ++side) {
+        int iflag = 0;
+        TProfile *profile = pFactory(TString::Format(region.name, l, side).Data(),
+                                     TString::Format(region.title, l, side).Data(),
                                      nProfileBins, -90., 90., Lorentz, iflag);
+        profile->GetXaxis()->SetTitle("#phi to Wafer");
+        profile->GetYaxis()->SetTitle("Num of Strips");
+        m_regionProfiles[r].push_back(profile);
+        success *= iflag;
+      }
+    }
+  }
 
-    m_phiVsNstrips[l] = pFactory("h_phiVsNstrips" + hNum[l], "Inc. Angle vs nStrips for Layer" + hNum[l], nProfileBins,
-                                 -90., 90., Lorentz, iflag);
-    m_phiVsNstrips[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstrips_075[l] = pFactory("h_phiVsNstrips_075_" + hNum[l], "Inc. Angle vs nStrips for Layer" + hNum[l], nProfileBins,
-				     -90., 90., Lorentz, iflag);
-    m_phiVsNstrips_075[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips_075[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstrips_15[l] = pFactory("h_phiVsNstrips_15_" + hNum[l], "Inc. Angle vs nStrips for Layer" + hNum[l], nProfileBins,
-				    -90., 90., Lorentz, iflag);
-    m_phiVsNstrips_15[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips_15[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstrips_more15[l] = pFactory("h_phiVsNstrips_more15_" + hNum[l], "Inc. Angle vs nStrips for Layer" + hNum[l], nProfileBins,
-					-90., 90., Lorentz, iflag);
-    m_phiVsNstrips_more15[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips_more15[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-
-    m_phiVsNstrips_100[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips_100[l]->GetYaxis()->SetTitle("Num of Strips");
-
-    m_phiVsNstrips_111[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstrips_111[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
+  for (int l = 0; l != nLayers; ++l) {
+    int iflag = 0;
     side0VsSide1_IncidenceAngle[l] = h2Factory("side0VsSide1_IncidenceAngle_" + hNum[l], "Inc. Angle, Side 1 vs Side 0 for layer " + hNum[l], 90.0, Lorentz, iflag);
     side0VsSide1_IncidenceAngle[l]->GetXaxis()->SetTitle("Inc. angle (#phi) [degrees], side 0");
     side0VsSide1_IncidenceAngle[l]->GetYaxis()->SetTitle("Inc. angle (#phi) [degrees], side 1");
-    
-    
-    
-    
-    for (int side = 0; side < nSides; ++side) {
-      m_phiVsNstrips_Side_100[l][side] = pFactory("h_phiVsNstrips_100_" + hNum[l] + "Side" + hNumS[side],
-                                                  "100 - Inc. Angle vs nStrips for Layer Side " + hNum[l] + hNumS[side],
-                                                  nProfileBins, -90., 90., Lorentz, iflag);
-      m_phiVsNstrips_Side_111[l][side] = pFactory("h_phiVsNstrips_111_" + hNum[l] + "Side" + hNumS[side],
-                                                  "111 - Inc. Angle vs nStrips for Layer Side " + hNum[l] + hNumS[side],
-                                                  nProfileBins, -90., 90., Lorentz, iflag);
-      m_phiVsNstrips_Side[l][side] = pFactory("h_phiVsNstrips" + hNum[l] + "Side" + hNumS[side],
-                                              "Inc. Angle vs nStrips for Layer Side" + hNum[l] + hNumS[side],
-                                              nProfileBins, -90., 90., Lorentz, iflag);
-
-      m_phiVsNstrips_Side[l][side]->GetXaxis()->SetTitle("#phi to Wafer");
-      m_phiVsNstrips_Side[l][side]->GetYaxis()->SetTitle("Num of Strips");
-
-      m_phiVsNstrips_Side_100[l][side]->GetXaxis()->SetTitle("#phi to Wafer");
-      m_phiVsNstrips_Side_100[l][side]->GetYaxis()->SetTitle("Num of Strips");
-
-      m_phiVsNstrips_Side_111[l][side]->GetXaxis()->SetTitle("#phi to Wafer");
-      m_phiVsNstrips_Side_111[l][side]->GetYaxis()->SetTitle("Num of Strips");
-    }
     success *= iflag;
   }
-  
-  for (int l = 0; l != nECLayers; ++l) {
-    int iflag = 0;
-    m_phiVsNstripsEC[l] = pFactory("h_phiVsNstripsEC" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-				   -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC_Inner[l] = pFactory("h_phiVsNstripsEC_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					 -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC_Middle[l] = pFactory("h_phiVsNstripsEC_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					  -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC_Outer[l] = pFactory("h_phiVsNstripsEC_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					 -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-     
-     
-     
-     
-     
-    m_phiVsNstripsEC2[l] = pFactory("h_phiVsNstripsEC2" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-				    -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC2[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC2[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC2_Inner[l] = pFactory("h_phiVsNstripsEC2_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					  -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC2_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC2_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC2_Middle[l] = pFactory("h_phiVsNstripsEC2_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					   -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC2_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC2_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsEC2_Outer[l] = pFactory("h_phiVsNstripsEC2_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					  -90., 90., Lorentz, iflag);
-    m_phiVsNstripsEC2_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsEC2_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-     
-     
-     
-     
-     
-     
-    m_phiVsNstripsECSide0[l] = pFactory("h_phiVsNstripsECSide0" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					-90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide0[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide0[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide0_Inner[l] = pFactory("h_phiVsNstripsECSide0_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					      -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide0_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide0_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide0_Middle[l] = pFactory("h_phiVsNstripsECSide0_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide0_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide0_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide0_Outer[l] = pFactory("h_phiVsNstripsECSide0_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					      -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide0_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide0_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-     
-     
-     
-     
-     
-    m_phiVsNstripsECSide02[l] = pFactory("h_phiVsNstripsECSide02" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					 -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide02[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide02[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide02_Inner[l] = pFactory("h_phiVsNstripsECSide02_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide02_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide02_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide02_Middle[l] = pFactory("h_phiVsNstripsECSide02_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-						-90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide02_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide02_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide02_Outer[l] = pFactory("h_phiVsNstripsECSide02_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide02_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide02_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-     
-     
-     
-     
-     
-    m_phiVsNstripsECSide1[l] = pFactory("h_phiVsNstripsECSide1" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					-90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide1[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide1[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide1_Inner[l] = pFactory("h_phiVsNstripsECSide1_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					      -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide1_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide1_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide1_Middle[l] = pFactory("h_phiVsNstripsECSide1_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide1_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide1_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide1_Outer[l] = pFactory("h_phiVsNstripsECSide1_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					      -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide1_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide1_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-     
-     
-     
-     
-     
-    m_phiVsNstripsECSide12[l] = pFactory("h_phiVsNstripsECSide12" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					 -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide12[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide12[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide12_Inner[l] = pFactory("h_phiVsNstripsECSide12_Inner_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide12_Inner[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide12_Inner[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide12_Middle[l] = pFactory("h_phiVsNstripsECSide12_Middle_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-						-90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide12_Middle[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide12_Middle[l]->GetYaxis()->SetTitle("Num of Strips");
-    
-    
-    m_phiVsNstripsECSide12_Outer[l] = pFactory("h_phiVsNstripsECSide12_Outer_" + hNumEC[l], "Inc. Angle vs nStrips for Layer" + hNumEC[l], nProfileBins,
-					       -90., 90., Lorentz, iflag);
-    m_phiVsNstripsECSide12_Outer[l]->GetXaxis()->SetTitle("#phi to Wafer");
-    m_phiVsNstripsECSide12_Outer[l]->GetYaxis()->SetTitle("Num of Strips");
-      
-    success *= iflag;
+
+  buildProfileFanOut();
+
+  // booked once: this runs again on every bookHistogramsRecurrent() call, and the tree keeps
+  // filling across them. A failure is reported there and leaves the profiles booked.
+  if (m_fillHitTree and not m_hitTree) {
+    bookHitTree(Lorentz);
   }
   
   if (success == 0) {
@@ -1607,6 +750,90 @@ SCTLorentzMonTool::bookLorentzHistos() {
   return StatusCode::SUCCESS;
 }
 
+// ====================================================================================================
+//                              SCTLorentzMonTool :: bookHitTree
+/// one entry per accepted hit, same branches as the tree made by MakeTree.C from the "Arka" printout,
+/// or with CompactHitTree those of its compact schema, where moduleKey is the wafer's cached key
+// ====================================================================================================
+int
+SCTLorentzMonTool::bookHitTree(MonGroup &registry) {
+  m_hitTree = new TTree("tree", m_compactHitTree ? "SCT Lorentz angle hits, compact schema" : "SCT Lorentz angle hits");
+  // a few hundred hits per event: start with 16k values per basket, the first
+  // ~30 MB cluster then lets ROOT resize the baskets to the actual rates
+  const int basketSize(128000);
+  if (m_compactHitTree) {
+    m_hitTree->Branch("event_number", &m_hitEventNumber,         "event_number/L", basketSize);
+    m_hitTree->Branch("pT",           &m_compactHit.pT,          "pT/F",           basketSize);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,16,0)
+    m_hitTree->Branch("trkEta",       &m_compactHit.trkEta,      "trkEta/f[-3,3,16]",             basketSize);
+    m_hitTree->Branch("trkPhi",       &m_compactHit.trkPhi,      "trkPhi/f[-3.1416,3.1416,16]",   basketSize);
+    m_hitTree->Branch("phiToWafer",   &m_compactHit.phiToWafer,  "phiToWafer/f[-90,90,16]",       basketSize);
+#else
+    m_hitTree->Branch("trkEta",       &m_compactHit.trkEta,      "trkEta/F",       basketSize);
+    m_hitTree->Branch("trkPhi",       &m_compactHit.trkPhi,      "trkPhi/F",       basketSize);
+    m_hitTree->Branch("phiToWafer",   &m_compactHit.phiToWafer,  "phiToWafer/F",   basketSize);
+#endif
+    m_hitTree->Branch("moduleKey",    &m_compactHit.moduleKey,   "moduleKey/i",    basketSize);
+    m_hitTree->Branch("nStrip",       &m_compactHit.nStrip,      "nStrip/S",       basketSize);
+    m_hitTree->Branch("charge",       &m_compactHit.charge,      "charge/B",       basketSize);
+    m_hitTree->SetAlias("bec",       "((moduleKey>>24)&0xff)-128");
+    m_hitTree->SetAlias("layer",     "(moduleKey>>16)&0xff");
+    m_hitTree->SetAlias("etaModule", "((moduleKey>>8)&0xff)-128");
+    m_hitTree->SetAlias("phiModule", "(moduleKey>>1)&0x7f");
+    m_hitTree->SetAlias("side",      "moduleKey&1");
+  } else {
+    m_hitTree->Branch("event_number", &m_hitEventNumber, "event_number/L", basketSize);
+    m_hitTree->Branch("pT",           &m_hitPt,          "pT/D",           basketSize);
+    m_hitTree->Branch("trkEta",       &m_hitTrkEta,      "trkEta/D",       basketSize);
+    m_hitTree->Branch("trkPhi",       &m_hitTrkPhi,      "trkPhi/D",       basketSize);
+    m_hitTree->Branch("phiToWafer",   &m_hitPhiToWafer,  "phiToWafer/D",   basketSize);
+    m_hitTree->Branch("nStrip",       &m_hitNStrip,      "nStrip/I",       basketSize);
+    m_hitTree->Branch("bec",          &m_hitBec,         "bec/I",          basketSize);
+    m_hitTree->Branch("layer",        &m_hitLayer,       "layer/I",        basketSize);
+    m_hitTree->Branch("etaModule",    &m_hitEtaModule,   "etaModule/I",    basketSize);
+    m_hitTree->Branch("phiModule",    &m_hitPhiModule,   "phiModule/I",    basketSize);
+    m_hitTree->Branch("side",         &m_hitSide,        "side/I",         basketSize);
+    m_hitTree->Branch("charge",       &m_hitCharge,      "charge/D",       basketSize);
+  }
+  m_hitTree->SetAutoFlush(-30000000);
+
+  if (registry.regTree(m_hitTree).isFailure()) {
+    msg(MSG::ERROR) << "Cannot book SCT hit tree, FillHitTree is ignored until it can be registered" << endmsg;
+    delete m_hitTree;
+    m_hitTree = nullptr;
+    return 0;
+  }
+  return 1;
+}
+
+void
+SCTLorentzMonTool::fillHitTree(uint64_t event_number, double pT, double trkEta, float trackPhi, float phiToWafer,
+                               int nStrip, const SCTLorentz::WaferModule &module, double charge) {
+  m_hitEventNumber = event_number;
+  if (m_compactHitTree) {
+    m_compactHit.pT = pT;
+    m_compactHit.trkEta = trkEta;
+    m_compactHit.trkPhi = trackPhi;
+    m_compactHit.phiToWafer = phiToWafer;
+    m_compactHit.moduleKey = module.moduleKey;
+    m_compactHit.nStrip = nStrip;
+    m_compactHit.charge = charge;
+  } else {
+    m_hitPt = pT;
+    m_hitTrkEta = trkEta;
+    m_hitTrkPhi = trackPhi;
+    m_hitPhiToWafer = phiToWafer;
+    m_hitNStrip = nStrip;
+    m_hitBec = module.bec;
+    m_hitLayer = module.layer;
+    m_hitEtaModule = module.eta;
+    m_hitPhiModule = module.phi;
+    m_hitSide = module.side;
+    m_hitCharge = charge;
+  }
+  m_hitTree->Fill();
+}
+
 TProfile *
 SCTLorentzMonTool::pFactory(const std::string &name, const std::string &title, int nbinsx, float xlow, float xhigh,
                             MonGroup &registry, int &iflag) {
@@ -1663,41 +890,20 @@ SCTLorentzMonTool::h2Factory(const std::string &name, const std::string &title,
 }
 
 
-int
-SCTLorentzMonTool::findAnglesToWaferSurface(const float (&vec)[3], const float &sinAlpha, const Identifier &id,
-                                            float &theta, float &phi) {
-  int iflag(-1);
-
-  phi = 90.;
-  theta = 90.;
-
-  InDetDD::SiDetectorElement *element = m_sctmgr->getDetectorElement(id);
-  if (!element) {
-    MsgStream log(msgSvc(), name());
-    log << MSG::ERROR << "findAnglesToWaferSurface:  failed to find detector element for id=" <<
-      m_pSCTHelper->show_to_string(id) << endmsg;
-    return iflag;
-  }
-
-  float cosAlpha = sqrt(1. - sinAlpha * sinAlpha);
-  float phix = cosAlpha * element->phiAxis().x() + sinAlpha * element->phiAxis().y();
-  float phiy = -sinAlpha *element->phiAxis().x() + cosAlpha * element->phiAxis().y();
-
-  float pNormal = vec[0] * element->normal().x() + vec[1] * element->normal().y() + vec[2] * element->normal().z();
-  float pEta = vec[0] * element->etaAxis().x() + vec[1] * element->etaAxis().y() + vec[2] * element->etaAxis().z();
-  float pPhi = vec[0] * phix + vec[1] * phiy + vec[2] * element->phiAxis().z();
-
-  if (pPhi < 0.) {
-    phi = -90.;
-  }
-  if (pEta < 0.) {
-    theta = -90.;
-  }
-  if (pNormal != 0.) {
-    phi = atan(pPhi / pNormal) / CLHEP::deg;
-    theta = atan(pEta / pNormal) / CLHEP::deg;
+/// The angles of the n hits of a track at once, by wafer hash and momentum; ok[i] is 0 where the
+/// wafer has no detector element. Returns the number of hits with angles.
+unsigned int
+SCTLorentzMonTool::findAnglesToWaferSurface(unsigned int n, const uint32_t *waferHashes, const float *px,
+                                            const float *py, const float *pz, float *theta, float *phi,
+                                            uint8_t *ok) const {
+  const unsigned int nOk = m_waferAxes.Angles(n, waferHashes, px, py, pz, theta, phi, ok);
+  for (unsigned int i = 0; nOk != n and i != n; ++i) {
+    if (not ok[i]) {
+      MsgStream log(msgSvc(), name());
+      log << MSG::ERROR << "findAnglesToWaferSurface:  failed to find detector element for id=" <<
+        m_pSCTHelper->show_to_string(m_pSCTHelper->wafer_id(IdentifierHash(waferHashes[i]))) << endmsg;
+    }
   }
-  iflag = 1;
-  return iflag;
+  return nOk;
 }
 
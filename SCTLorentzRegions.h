@@ -0,0 +1,124 @@
+#ifndef SCTLORENTZREGIONS_H
+#define SCTLORENTZREGIONS_H
+
+// The phiToWafer vs nStrip profiles booked by
+// SCTLorentzMonTool::bookLorentzHistos() and the hits each of them takes in
+// fillHistograms(), as one table for the tool and the offline filler
+// (FillLorentzProfiles.C). A hit goes into every region it matches, into the
+// profile of its layer, and of its side for the per-side profiles. Several
+// rows may name the same profile. Hits on track holes (nStrip 0 in the
+// printout) fill a slightly different set of end-cap regions than
+// measurements do, see the paths column.
+
+#include <cmath>
+#include "SCTLorentzModuleTables.h"
+
+namespace SCTLorentz {
+
+constexpr int    kNProfileBins = 360;
+constexpr double kProfileLow = -90., kProfileHigh = 90.;
+constexpr int    kNBarrelLayers = 4, kNEndcapDisks = 9, kNSides = 2;
+
+enum { kMeasurement = 1, kHole = 2, kBothPaths = 3 };
+enum { kAnyWafer = 0, kWafer100 = 1, kWafer111 = 2 };
+
+struct ProfileRegion {
+    const char *name;              // printf format: layer, then side if perSide
+    const char *title;             // same arguments
+    int         bec;               // 0 barrel, -2 end cap C, 2 end cap A
+    bool        perSide;
+    int         phiMin, phiMax;    // phi module, inclusive
+    int         etaMin, etaMax;    // eta module, inclusive
+    int         side;              // -1 both
+    double      absEtaMin, absEtaMax; // track |eta| in (min, max]; min < 0 includes 0
+    int         wafer;             // kAnyWafer, kWafer100, kWafer111 (barrel only)
+    int         paths;             // kMeasurement, kHole or both
+};
+
+constexpr double kAnyEta = 1e9;
+
+constexpr ProfileRegion kProfileRegions[] = {
+    // barrel, one profile per layer or per layer and side
+    {"h_phiVsNstrips%d",         "Inc. Angle vs nStrips for Layer%d", 0, false, 0, 99, -99, 99, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstrips_075_%d",    "Inc. Angle vs nStrips for Layer%d", 0, false, 0, 99, -99, 99, -1, -1., 0.75,    kAnyWafer, kBothPaths},
+    {"h_phiVsNstrips_15_%d",     "Inc. Angle vs nStrips for Layer%d", 0, false, 0, 99, -99, 99, -1, 0.75, 1.5,    kAnyWafer, kBothPaths},
+    {"h_phiVsNstrips_more15_%d", "Inc. Angle vs nStrips for Layer%d", 0, false, 0, 99, -99, 99, -1, 1.5, kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstrips_100%d", "100 - Inc. Angle vs nStrips for Layer %d", 0, false, 0, 99, -99, 99, -1, -1., kAnyEta, kWafer100, kBothPaths},
+    {"h_phiVsNstrips_111%d", "111 - Inc. Angle vs nStrips for Layer %d", 0, false, 0, 99, -99, 99, -1, -1., kAnyEta, kWafer111, kBothPaths},
+    {"h_phiVsNstrips%dSide%d",      "Inc. Angle vs nStrips for Layer Side%d%d",        0, true, 0, 99, -99, 99, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstrips_100_%dSide%d", "100 - Inc. Angle vs nStrips for Layer Side %d%d", 0, true, 0, 99, -99, 99, -1, -1., kAnyEta, kWafer100, kBothPaths},
+    {"h_phiVsNstrips_111_%dSide%d", "111 - Inc. Angle vs nStrips for Layer Side %d%d", 0, true, 0, 99, -99, 99, -1, -1., kAnyEta, kWafer111, kBothPaths},
+
+    // end cap C, quadrant 1; holes also fill these from phi 20-38
+    {"h_phiVsNstripsEC%d",        "Inc. Angle vs nStrips for Layer%d", -2, false,  0, 12, 0, 2, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC_Inner_%d", "Inc. Angle vs nStrips for Layer%d", -2, false,  0,  9, 2, 2, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC_Middle_%d","Inc. Angle vs nStrips for Layer%d", -2, false,  0,  9, 1, 1, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC_Outer_%d", "Inc. Angle vs nStrips for Layer%d", -2, false,  0, 12, 0, 0, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC%d",        "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 38, 0, 2, -1, -1., kAnyEta, kAnyWafer, kHole},
+    {"h_phiVsNstripsEC_Inner_%d", "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 2, 2, -1, -1., kAnyEta, kAnyWafer, kHole},
+    {"h_phiVsNstripsEC_Middle_%d","Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 1, 1, -1, -1., kAnyEta, kAnyWafer, kHole},
+    {"h_phiVsNstripsEC_Outer_%d", "Inc. Angle vs nStrips for Layer%d", -2, false, 26, 38, 0, 0, -1, -1., kAnyEta, kAnyWafer, kHole},
+
+    // end cap A, quadrant 2
+    {"h_phiVsNstripsEC2%d",        "Inc. Angle vs nStrips for Layer%d", 2, false, 10, 26, 0, 2, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC2_Inner_%d", "Inc. Angle vs nStrips for Layer%d", 2, false, 11, 20, 2, 2, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC2_Middle_%d","Inc. Angle vs nStrips for Layer%d", 2, false, 10, 19, 1, 1, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsEC2_Outer_%d", "Inc. Angle vs nStrips for Layer%d", 2, false, 14, 26, 0, 0, -1, -1., kAnyEta, kAnyWafer, kBothPaths},
+
+    // end caps per side, phi 20-38; end cap C side 0 only from measurements
+    {"h_phiVsNstripsECSide0%d",         "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 38, 0, 2, 0, -1., kAnyEta, kAnyWafer, kMeasurement},
+    {"h_phiVsNstripsECSide0_Inner_%d",  "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 2, 2, 0, -1., kAnyEta, kAnyWafer, kMeasurement},
+    {"h_phiVsNstripsECSide0_Middle_%d", "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 1, 1, 0, -1., kAnyEta, kAnyWafer, kMeasurement},
+    {"h_phiVsNstripsECSide0_Outer_%d",  "Inc. Angle vs nStrips for Layer%d", -2, false, 26, 38, 0, 0, 0, -1., kAnyEta, kAnyWafer, kMeasurement},
+    {"h_phiVsNstripsECSide02%d",        "Inc. Angle vs nStrips for Layer%d",  2, false, 20, 38, 0, 2, 0, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide02_Inner_%d", "Inc. Angle vs nStrips for Layer%d",  2, false, 20, 29, 2, 2, 0, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide02_Middle_%d","Inc. Angle vs nStrips for Layer%d",  2, false, 20, 29, 1, 1, 0, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide02_Outer_%d", "Inc. Angle vs nStrips for Layer%d",  2, false, 26, 38, 0, 0, 0, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide1%d",         "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 38, 0, 2, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide1_Inner_%d",  "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 2, 2, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide1_Middle_%d", "Inc. Angle vs nStrips for Layer%d", -2, false, 20, 29, 1, 1, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide1_Outer_%d",  "Inc. Angle vs nStrips for Layer%d", -2, false, 26, 38, 0, 0, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide12%d",        "Inc. Angle vs nStrips for Layer%d",  2, false, 20, 38, 0, 2, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide12_Inner_%d", "Inc. Angle vs nStrips for Layer%d",  2, false, 20, 29, 2, 2, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide12_Middle_%d","Inc. Angle vs nStrips for Layer%d",  2, false, 20, 29, 1, 1, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+    {"h_phiVsNstripsECSide12_Outer_%d", "Inc. Angle vs nStrips for Layer%d",  2, false, 26, 38, 0, 0, 1, -1., kAnyEta, kAnyWafer, kBothPaths},
+};
+
+constexpr unsigned int kNProfileRegions = sizeof(kProfileRegions) / sizeof(*kProfileRegions);
+
+// Layers (barrel) or disks (end caps) of a region, and the number of
+// profiles it has: one per layer, or per layer and side.
+inline int RegionLayers(const ProfileRegion &region){
+    return region.bec == 0 ? kNBarrelLayers : kNEndcapDisks;
+}
+
+inline int RegionProfiles(const ProfileRegion &region){
+    return RegionLayers(region) * (region.perSide ? kNSides : 1);
+}
+
+// Index of the module's profile within the region, -1 if the module is not
+// in it; the track eta slice is not tested. path is kMeasurement or kHole.
+// Depends on the module only, so it can be evaluated once per wafer.
+inline int RegionModuleProfile(const ProfileRegion &region, int path, int bec, int layer, int eta, int phi, int side){
+    if (bec != region.bec || !(region.paths & path) || layer < 0 || layer >= RegionLayers(region)) return -1;
+    if (phi < region.phiMin || phi > region.phiMax || eta < region.etaMin || eta > region.etaMax) return -1;
+    if (side < 0 || side >= kNSides || (region.side >= 0 && side != region.side)) return -1;
+    if (region.wafer != kAnyWafer && IsWafer100(layer, eta, phi) != (region.wafer == kWafer100)) return -1;
+    return region.perSide ? layer * kNSides + side : layer;
+}
+
+inline bool RegionTrackEta(const ProfileRegion &region, double trkEta){
+    double absEta = std::fabs(trkEta);
+    return absEta > region.absEtaMin && absEta <= region.absEtaMax;
+}
+
+// Index of the hit's profile within the region, -1 if the hit is not in it.
+inline int RegionProfile(const ProfileRegion &region, int path, int bec, int layer, int eta, int phi, int side,
+                         double trkEta){
+    int index = RegionModuleProfile(region, path, bec, layer, eta, phi, side);
+    return index >= 0 && RegionTrackEta(region, trkEta) ? index : -1;
+}
+
+}
+
+#endif
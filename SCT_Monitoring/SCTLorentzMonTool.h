@@ -0,0 +1,224 @@
+// -*- C++ -*-
+
+/*
+  Copyright (C) 2002-2017 CERN for the benefit of the ATLAS collaboration
+*/
+
+/**    @file SCTLorentzMonTool.h
+ *   Class declaration for SCTLorentzMonTool
+ *
+ *    @author Elias Coniavitis based on code from Luca Fiorini,
+ *    Shaun Roe, Manuel Diaz, Rob McPherson & Richard Batley
+ *    Modified by Yuta
+ */
+
+#ifndef SCTLORENTZMONTOOL_H
+#define SCTLORENTZMONTOOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GaudiKernel/ToolHandle.h"
+#include "AthenaKernel/IOVSvcDefs.h"
+#include "StoreGate/DataHandle.h"
+#include "SCT_Monitoring/SCTMotherTrigMonTool.h"
+#include "ITrackToVertex/ITrackToVertex.h" //for ToolHandle<Reco::ITrackToVertex>
+#include "TrkToolInterfaces/ITrackHoleSearchTool.h"
+#include "TrkParameters/TrackParameters.h"
+#include "DetDescrConditions/AlignableTransformContainer.h"
+#include "Identifier/IdentifierHash.h"
+#include "SCTLorentzModuleTables.h"
+#include "SCTLorentzGeometry.h"
+#include "Rtypes.h" // Long64_t, Float16_t
+
+// Forward declarations
+class IInterface;
+class TH1F;
+class TH2F;
+class TProfile;
+class TTree;
+class StatusCode;
+class SCT_ID;
+class ArkaRecordWriter;
+
+namespace InDetDD {
+  class SCT_DetectorManager;
+}
+
+namespace Trk {
+  class TrackStateOnSurface;
+}
+
+///Concrete monitoring tool derived from SCTMotherTrigMonTool
+class SCTLorentzMonTool : public SCTMotherTrigMonTool{
+ public:
+  SCTLorentzMonTool(const std::string & type, const std::string & name, const IInterface* parent);
+  virtual ~SCTLorentzMonTool();
+  virtual StatusCode initialize();
+  virtual StatusCode finalize();
+  /**    @name Book, fill & check (reimplemented from baseclass) */
+//@{
+  ///Book histograms in initialization
+  //virtual StatusCode bookHistograms(bool isNewEventsBlock, bool isNewLumiBlock, bool isNewRun);
+  virtual StatusCode bookHistogramsRecurrent();
+  virtual StatusCode bookHistograms();
+  ///Fill histograms in each loop
+  virtual StatusCode fillHistograms();
+  ///process histograms at the end (we only use 'isEndOfRun')
+  //virtual StatusCode procHistograms(bool isEndOfEventsBlock, bool isEndOfLumiBlock, bool isEndOfRun);
+  virtual StatusCode procHistograms();
+  ///helper function used in procHistograms
+  StatusCode checkHists(bool fromFinalize);
+//@}
+
+private:
+  typedef TProfile * Prof_t;
+  typedef TH1F * H1_t;
+  typedef TH2F * H2_t;
+  typedef std::vector<H1_t> VecH1_t;
+
+  /// a profile a hit on a given wafer goes into, and the track |eta| slice (min, max] it takes
+  struct ProfileFill {
+    TProfile *profile;
+    double absEtaMin, absEtaMax;
+  };
+
+  /// the SCT measurements and holes of one track, in track order, with the arrays the angles to
+  /// the wafers are found from in one findAnglesToWaferSurface call
+  struct TrackHits {
+    std::vector<int> path; // SCTLorentz::kMeasurement or kHole
+    std::vector<const Trk::TrackParameters *> parameters;
+    std::vector<int> nStrip;
+    std::vector<uint32_t> waferHash;
+    std::vector<float> px, py, pz;
+    std::vector<float> theta, phi;
+    std::vector<uint8_t> ok;
+    unsigned int size() const { return path.size(); }
+    void clear() {
+      path.clear(); parameters.clear(); nStrip.clear(); waferHash.clear();
+      px.clear(); py.clear(); pz.clear(); theta.clear(); phi.clear(); ok.clear();
+    }
+    void add(int hitPath, const Trk::TrackParameters *trkp, uint32_t hash, int strips, float x, float y, float z) {
+      path.push_back(hitPath);
+      parameters.push_back(trkp);
+      nStrip.push_back(strips);
+      waferHash.push_back(hash);
+      px.push_back(x);
+      py.push_back(y);
+      pz.push_back(z);
+      theta.push_back(90.f);
+      phi.push_back(90.f);
+      ok.push_back(0);
+    }
+  };
+
+  //@name Histograms
+  //@{
+  /// the angle vs nStrip profiles, by row of SCTLorentz::kProfileRegions, then layer (and side)
+  std::vector<std::vector<TProfile *>> m_regionProfiles;
+  /// per path (measurement, hole): the profiles of wafer hash h are
+  /// m_profileFanOut[path][m_profileFanOutBegin[path][h] .. m_profileFanOutBegin[path][h + 1]]
+  std::vector<ProfileFill> m_profileFanOut[2];
+  std::vector<uint32_t> m_profileFanOutBegin[2];
+  H2_t side0VsSide1_IncidenceAngle[4];
+  //@}
+
+  std::string m_stream;
+  std::string m_path;
+  int m_numberOfEvents;
+
+  //@name Service members
+  //@{
+  /// Track collection name
+  std::string m_tracksName;
+  ToolHandle<Reco::ITrackToVertex> m_trackToVertexTool;
+  ToolHandle<Trk::ITrackHoleSearchTool> m_holeSearchTool;
+  ///SCT Helper class
+  const SCT_ID* m_pSCTHelper;
+  ///SCT Detector Manager
+  const InDetDD::SCT_DetectorManager* m_sctmgr;
+  //@}
+
+  //@name Per-wafer tables, by wafer hash
+  //@{
+  /// decoded identifier, module key and category flags
+  std::vector<SCTLorentz::WaferModule> m_waferModules;
+  /// normal, phi and eta axes for the track angles
+  SCTLorentz::WaferAxes m_waferAxes;
+  /// false after an alignment update until m_waferAxes is rebuilt
+  bool m_waferGeometryValid;
+  std::string m_alignmentFolder;
+  const DataHandle<AlignableTransformContainer> m_alignmentHandle;
+  //@}
+
+  /// hits of the track being filled, kept to reuse the storage
+  TrackHits m_trackHits;
+
+  //@name Module categories
+  //@{
+  std::string m_moduleCategoryFile;
+  std::vector<std::string> m_moduleCategoryRules;
+  std::vector<std::string> m_selectModuleCategories;
+  /// 0: no selection
+  uint32_t m_selectedModulesMask = 0;
+  //@}
+
+  //@name Per-hit outputs
+  //@{
+  /// binary ArkaHitRecord file, empty for none
+  std::string m_hitRecordFile;
+  std::unique_ptr<ArkaRecordWriter> m_hitRecords;
+  bool m_fillHitTree;
+  /// m_hitTree with the compact schema of MakeTree.C instead of the full one
+  bool m_compactHitTree;
+  TTree *m_hitTree;
+  /// branch buffers of m_hitTree, full schema
+  Long64_t m_hitEventNumber;
+  double m_hitPt, m_hitTrkEta, m_hitTrkPhi, m_hitPhiToWafer, m_hitCharge;
+  int m_hitNStrip, m_hitBec, m_hitLayer, m_hitEtaModule, m_hitPhiModule, m_hitSide;
+  /// the same for the compact schema, with event_number in m_hitEventNumber
+  struct CompactHit {
+    Float_t pT;
+    Float16_t trkEta, trkPhi, phiToWafer;
+    UInt_t moduleKey;
+    Short_t nStrip;
+    Char_t charge;
+  } m_compactHit;
+  //@}
+
+  //@name  Histograms related methods
+  //@{
+  StatusCode bookLorentzHistos();
+  int bookHitTree(MonGroup &registry);
+  void buildProfileFanOut();
+  void fillProfiles(int path, const IdentifierHash &waferHash, float phiToWafer, int nStrip, double trkEta);
+  void fillHitTree(uint64_t event_number, double pT, double trkEta, float trackPhi, float phiToWafer,
+                   int nStrip, const SCTLorentz::WaferModule &module, double charge);
+  //@}
+
+  //@name Service methods
+  //@{
+  StatusCode buildWaferModules();
+  StatusCode buildWaferGeometry();
+  StatusCode alignmentCallback(IOVSVC_CALLBACK_ARGS);
+  /// false if the hole is not on the SCT
+  bool holeWaferHash(const Trk::TrackStateOnSurface *tsos, IdentifierHash &waferHash) const;
+  // Calculate the local angles of incidence of the n hits of a track
+  unsigned int findAnglesToWaferSurface(unsigned int n, const uint32_t *waferHashes, const float *px,
+                                        const float *py, const float *pz, float *theta, float *phi,
+                                        uint8_t *ok) const;
+
+  ///Factory + register for the profiles, iflag is 0 if it could not be registered
+  Prof_t pFactory(const std::string & name, const std::string & title, int nbinsx, float xlow, float xhigh,
+                  MonGroup & registry, int& iflag);
+  ///Factory + register for the 1D histograms, returns whether successfully registered
+  bool h1Factory(const std::string & name, const std::string & title, const float extent, MonGroup & registry,
+                 VecH1_t & storageVector);
+  ///Factory + register for the 2D histograms, iflag is 0 if it could not be registered
+  H2_t h2Factory(const std::string & name, const std::string & title, const float extent, MonGroup & registry,
+                 int& iflag);
+  //@}
+};
+
+#endif